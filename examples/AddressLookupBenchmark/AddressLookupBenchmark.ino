@@ -0,0 +1,124 @@
+/*
+ * Microbenchmark: group address lookup on telegram reception.
+ *
+ * Compares the former lookup (binary search in the address table, binary
+ * search in the association table, then scanning backwards/forwards) with
+ * KnxAddressIndex for address/association table sizes 1..255.
+ *
+ * For each table size, half of the looked up GAs are assigned and half are
+ * not (most telegrams on a real bus are not addressed to us).
+ * Output (CSV, times in ns per lookup): size;old;new
+ *
+ * No KNX bus or TPUART is needed, the result is printed on "Serial".
+ */
+#include <KonnektingDevice.h>
+
+#define BENCHMARK_LOOKUPS 256
+
+// Definition of the Communication Objects attached to the device
+KnxComObject KnxDevice::_comObjectsList[] = {
+    /* Suite-Index 0 : */ KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject); // do no change this code
+KNX_COMOBJ_VALUE_ARENA(knxValueArenaSize(KNX_DPT_1_001));
+
+// Definition of parameter size
+byte KonnektingDevice::_paramSizeList[] = {
+    /* Param Index 0 */ PARAM_UINT16
+};
+const int KonnektingDevice::_numberOfParams = sizeof (_paramSizeList); // do no change this code
+
+void knxEvents(byte index) {
+}
+
+word addresses[255];
+byte gaIds[255];
+byte coIds[255];
+word lookups[BENCHMARK_LOOKUPS];
+byte found[255];
+KnxAddressIndex addressIndex;
+volatile byte sink; // keeps the compiler from optimizing the lookups away
+
+// former lookup, as done by KnxTpUart::isAddressAssigned() before KnxAddressIndex
+byte oldLookup(word addr, byte addressNb, byte assocNb, byte list[]) {
+    int l = 0;
+    int r = addressNb - 1;
+    int addressId = -1;
+    while (l <= r) {
+        int m = l + (r - l) / 2;
+        if (addresses[m] == addr) {
+            addressId = m;
+            break;
+        }
+        if (addr > addresses[m]) l = m + 1;
+        else r = m - 1;
+    }
+    if (addressId < 0) return 0;
+
+    l = 0;
+    r = assocNb - 1;
+    int index = -1;
+    while (l <= r) {
+        int m = l + (r - l) / 2;
+        if (gaIds[m] == addressId) {
+            index = m;
+            break;
+        }
+        if (addressId > gaIds[m]) l = m + 1;
+        else r = m - 1;
+    }
+    if (index < 0) return 0;
+
+    byte items = 0;
+    list[items++] = coIds[index];
+    for (int i = index - 1; (i >= 0) && (gaIds[i] == addressId); i--) list[items++] = coIds[i];
+    for (int i = index + 1; (i < assocNb) && (gaIds[i] == addressId); i++) list[items++] = coIds[i];
+    return items;
+}
+
+// sorted, unique GAs with one association each
+void fillTables(byte size) {
+    for (byte i = 0; i < size; i++) {
+        addresses[i] = G_ADDR(1, 0, 0) + 3 * i;
+        gaIds[i] = i;
+        coIds[i] = i;
+    }
+    for (int i = 0; i < BENCHMARK_LOOKUPS; i++) {
+        lookups[i] = (i & 1) ? addresses[random(size)] : (word)(G_ADDR(1, 0, 0) + 3 * random(size) + 1);
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(3000);
+    Serial.println(F("size;old;new"));
+
+    for (int size = 1; size <= 255; size++) {
+        fillTables(size);
+        addressIndex.build(addresses, size, gaIds, coIds, size);
+
+        unsigned long start = micros();
+        for (int i = 0; i < BENCHMARK_LOOKUPS; i++) {
+            sink += oldLookup(lookups[i], size, size, found);
+        }
+        unsigned long oldTime = micros() - start;
+
+        byte* list;
+        start = micros();
+        for (int i = 0; i < BENCHMARK_LOOKUPS; i++) {
+            sink += addressIndex.find(lookups[i], list);
+        }
+        unsigned long newTime = micros() - start;
+
+        Serial.print(size);
+        Serial.print(';');
+        Serial.print(oldTime * 1000 / BENCHMARK_LOOKUPS);
+        Serial.print(';');
+        Serial.println(newTime * 1000 / BENCHMARK_LOOKUPS);
+    }
+    addressIndex.clear();
+    Serial.println(F("done"));
+}
+
+void loop() {
+}
@@ -75,6 +75,7 @@ KnxComObject KnxDevice::_comObjectsList[] = {
     /* Suite-Index 1 : */ KnxComObject(KNX_DPT_1_001, COM_OBJ_SENSOR),
 };
 const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject); // do no change this code
+KNX_COMOBJ_VALUE_ARENA(knxValueArenaSize(KNX_DPT_1_001, KNX_DPT_1_001));
 
 // Definition of parameter size
 byte KonnektingDevice::_paramSizeList[] = {
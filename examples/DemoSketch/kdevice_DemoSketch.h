@@ -11,6 +11,7 @@ KnxComObject KnxDevice::_comObjectsList[] = {
     /* Index 1 - trigger */ KnxComObject(KNX_DPT_1_001, 0x34)
 };
 const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject); // do not change this code
+KNX_COMOBJ_VALUE_ARENA(knxValueArenaSize(KNX_DPT_1_001, KNX_DPT_1_001));
        
 byte KonnektingDevice::_paramSizeList[] = {
     /* Index 0 - blinkDelay */ PARAM_UINT16
@@ -0,0 +1,123 @@
+/*
+ * Minimal Arduino core for building the library on a host (see ../Makefile)
+ * Only what the library sources use is declared, the serial port simulates a TPUART (see tpuart_sim.h)
+ */
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <type_traits>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const byte*)(p))
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper*)(s))
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+#define SERIAL_8E1 0
+
+// binary constants used by the library
+#define B00000000 0x00
+#define B00000001 0x01
+#define B00000010 0x02
+#define B00000100 0x04
+#define B00001000 0x08
+#define B00001010 0x0A
+#define B00001100 0x0C
+#define B00001111 0x0F
+#define B00010000 0x10
+#define B00010011 0x13
+#define B00100000 0x20
+#define B01110000 0x70
+#define B10000000 0x80
+#define B10010000 0x90
+#define B10111100 0xBC
+#define B11000000 0xC0
+#define B11010011 0xD3
+#define B11011111 0xDF
+#define B11100001 0xE1
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+long random(long max);
+long random(long min, long max);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void attachInterrupt(int interrupt, void (*isr)(void), int mode);
+int digitalPinToInterrupt(int pin);
+void noInterrupts(void);
+void interrupts(void);
+
+template <class A, class B> typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template <class A, class B> typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+#define lowByte(w) ((byte)((w) & 0xff))
+#define highByte(w) ((byte)((w) >> 8))
+
+class Print {
+   public:
+    virtual ~Print() {}
+    virtual size_t write(byte) = 0;
+    size_t print(const char*);
+    size_t print(const __FlashStringHelper*);
+    size_t println(const char*);
+    size_t println(const __FlashStringHelper*);
+    size_t println(void);
+};
+
+class Stream : public Print {
+   public:
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    virtual int peek(void) = 0;
+};
+
+class HardwareSerial : public Stream {
+   public:
+    void begin(unsigned long baud, int config = 0);
+    void end(void);
+    int available(void);
+    int read(void);
+    int peek(void);
+    size_t write(byte data);
+    size_t write(const byte* data, size_t length);
+    int availableForWrite(void);
+    void flush(void);
+    operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+
+class String {
+   public:
+    String(const char* str = "");
+    String(int value, int base = 10);
+    String operator+(const String&) const;
+    String& operator+=(const String&);
+    String& operator+=(const char*);
+    String& operator+=(int);
+    String& operator+=(char);
+};
+String operator+(const char*, const String&);
+
+#include "EEPROM.h"
+
+#endif // ARDUINO_H
@@ -0,0 +1,16 @@
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include "Arduino.h"
+
+// EEPROM of the host build, kept in RAM
+class EEPROMClass {
+   public:
+    byte read(int index);
+    void write(int index, byte value);
+    void update(int index, byte value);
+    word length(void);
+};
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_H
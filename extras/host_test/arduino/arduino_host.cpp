@@ -0,0 +1,193 @@
+/*
+ * Arduino core of the host build: time, EEPROM in RAM, silent debug output,
+ * and the TPUART simulated behind Serial (see tpuart_sim.h)
+ */
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "Arduino.h"
+#include "DebugUtil.h"
+#include "tpuart_sim.h"
+
+// --------------- Time -----------------
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long micros(void) {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long millis(void) {
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+long random(long max) {
+    return max ? rand() % max : 0;
+}
+
+long random(long min, long max) {
+    return min + random(max - min);
+}
+
+// --------------- Pins, interrupts -----------------
+
+void pinMode(int, int) {}
+void digitalWrite(int, int) {}
+int digitalRead(int) { return LOW; }
+void attachInterrupt(int, void (*)(void), int) {}
+int digitalPinToInterrupt(int pin) { return pin; }
+void noInterrupts(void) {}
+void interrupts(void) {}
+
+// --------------- Print, String (no output) -----------------
+
+size_t Print::print(const char*) { return 0; }
+size_t Print::print(const __FlashStringHelper*) { return 0; }
+size_t Print::println(const char*) { return 0; }
+size_t Print::println(const __FlashStringHelper*) { return 0; }
+size_t Print::println(void) { return 0; }
+
+String::String(const char*) {}
+String::String(int, int) {}
+String String::operator+(const String&) const { return *this; }
+String& String::operator+=(const String&) { return *this; }
+String& String::operator+=(const char*) { return *this; }
+String& String::operator+=(int) { return *this; }
+String& String::operator+=(char) { return *this; }
+String operator+(const char*, const String& str) { return str; }
+
+DebugUtil DebugUtil::Debug;
+DebugUtil& Debug = DebugUtil::Debug;
+DebugUtil::DebugUtil() : _printstream(NULL) {}
+void DebugUtil::print(const char*, ...) {}
+void DebugUtil::print(const __FlashStringHelper*, ...) {}
+void DebugUtil::println(const char*, ...) {}
+void DebugUtil::println(const __FlashStringHelper*, ...) {}
+
+// --------------- EEPROM -----------------
+
+EEPROMClass EEPROM;
+static byte eepromData[4096];
+static bool eepromErased = (memset(eepromData, 0xFF, sizeof(eepromData)), true);  // blank memory, factory setting
+
+byte EEPROMClass::read(int index) {
+    return eepromData[index];
+}
+
+void EEPROMClass::write(int index, byte value) {
+    eepromData[index] = value;
+}
+
+void EEPROMClass::update(int index, byte value) {
+    eepromData[index] = value;
+}
+
+word EEPROMClass::length(void) {
+    return sizeof(eepromData);
+}
+
+// --------------- Serial: simulated TPUART -----------------
+
+#define TPUART_RESET_REQ 0x01
+#define TPUART_RESET_INDICATION 0x03
+#define TPUART_DATA_CONFIRM_SUCCESS 0x8B
+#define TPUART_DATA_START_CONTINUE_REQ 0x80
+#define TPUART_DATA_END_REQ 0x40
+
+static std::mutex simMutex;
+static std::deque<byte> simRx;       // bytes to the library
+static byte simTelegram[23];         // telegram being sent by the library
+static int simDataIndex = -1;        // index of the next data byte, -1 if a service is expected
+static bool simDataEnd = false;      // the next data byte ends the telegram
+static bool simHold = false;
+static unsigned int simHeldConfirms = 0;
+static unsigned int simSentTelegrams = 0;
+static word simLastTarget = 0;
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long, int) {}
+
+void HardwareSerial::end(void) {}
+
+int HardwareSerial::available(void) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    return (int)simRx.size();
+}
+
+int HardwareSerial::read(void) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    if (simRx.empty()) return -1;
+    byte data = simRx.front();
+    simRx.pop_front();
+    return data;
+}
+
+int HardwareSerial::peek(void) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    return simRx.empty() ? -1 : simRx.front();
+}
+
+size_t HardwareSerial::write(byte data) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    if (simDataIndex >= 0) {  // data byte of the telegram
+        if (simDataIndex < (int)sizeof(simTelegram)) simTelegram[simDataIndex] = data;
+        simDataIndex = -1;
+        if (simDataEnd) {
+            simSentTelegrams++;
+            simLastTarget = ((word)simTelegram[3] << 8) | simTelegram[4];
+            if (simHold) simHeldConfirms++;
+            else simRx.push_back(TPUART_DATA_CONFIRM_SUCCESS);
+        }
+    } else if (data == TPUART_RESET_REQ) {
+        simRx.push_back(TPUART_RESET_INDICATION);
+    } else if (data & TPUART_DATA_START_CONTINUE_REQ) {
+        simDataIndex = data & 0x3F;
+        simDataEnd = false;
+    } else if (data & TPUART_DATA_END_REQ) {
+        simDataIndex = data & 0x3F;
+        simDataEnd = true;
+    }
+    // RX ACK services and state requests need no answer
+    return 1;
+}
+
+size_t HardwareSerial::write(const byte* data, size_t length) {
+    for (size_t i = 0; i < length; i++) write(data[i]);
+    return length;
+}
+
+int HardwareSerial::availableForWrite(void) {
+    return 64;
+}
+
+void HardwareSerial::flush(void) {}
+
+void tpuartSimInject(const byte data[], byte length) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    for (byte i = 0; i < length; i++) simRx.push_back(data[i]);
+}
+
+void tpuartSimHoldConfirms(bool hold) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    simHold = hold;
+    if (!hold) {
+        for (; simHeldConfirms; simHeldConfirms--) simRx.push_back(TPUART_DATA_CONFIRM_SUCCESS);
+    }
+}
+
+unsigned int tpuartSimSentTelegrams(void) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    return simSentTelegrams;
+}
+
+word tpuartSimLastTarget(void) {
+    std::lock_guard<std::mutex> lock(simMutex);
+    return simLastTarget;
+}
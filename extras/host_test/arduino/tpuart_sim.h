@@ -0,0 +1,21 @@
+/*
+ * TPUART simulated behind the Serial port of the host build
+ * It answers the reset request, confirms each telegram sent (unless held) and delivers injected bytes.
+ * Thread safe: the KNX task uses the port while the test injects bytes.
+ */
+#ifndef TPUART_SIM_H
+#define TPUART_SIM_H
+
+#include "Arduino.h"
+
+// Queue bytes received from the bus
+void tpuartSimInject(const byte data[], byte length);
+
+// Hold the confirms of the telegrams sent (true), or send them, the held ones first (false)
+void tpuartSimHoldConfirms(bool hold);
+
+// Nb of telegrams sent by the library, and the target address of the last one
+unsigned int tpuartSimSentTelegrams(void);
+word tpuartSimLastTarget(void);
+
+#endif // TPUART_SIM_H
@@ -0,0 +1,163 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host test of the KNX task (KNX_RTOS_PTHREAD variant of KnxRtos.h), see Makefile
+ * The KNX stack runs in its own thread against the simulated TPUART, the test plays the application:
+ * it starts and stops the task, and round-trips TX actions and com object updates through the rings.
+ */
+#include <thread>
+
+#include <KonnektingDevice.h>
+#include "arduino/tpuart_sim.h"
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                         \
+        }                                                                    \
+    } while (0)
+
+#define TEST_GA G_ADDR(1, 2, 3)
+#define TEST_TIMEOUT_MILLIS 5000
+
+KnxComObject KnxDevice::_comObjectsList[] = {
+    /* Index 0 */ KnxComObject(KNX_DPT_1_001, COM_OBJ_SENSOR),
+    /* Index 1 */ KnxComObject(KNX_DPT_5_010, COM_OBJ_SENSOR),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof(_comObjectsList) / sizeof(KnxComObject);
+KNX_COMOBJ_VALUE_ARENA(knxValueArenaSize(KNX_DPT_1_001, KNX_DPT_5_010));
+
+byte KonnektingDevice::_paramSizeList[] = {PARAM_UINT8};
+const int KonnektingDevice::_numberOfParams = sizeof(_paramSizeList);
+
+// Completions received by the application, per action id
+static byte completions[256];
+static byte completionOutcome[256];
+
+static void onTxCompletion(const KnxTxCompletion& completion) {
+    completions[completion.id & 0xFF]++;
+    completionOutcome[completion.id & 0xFF] = completion.outcome;
+}
+
+// Updates received by the application, and the prog com obj payload read while dispatched
+static int progEvents = 0;
+static byte progValue[14];
+
+void knxEvents(byte index) {
+    if (index != 255) return;
+    progEvents++;
+    Knx.read(255, progValue);
+}
+
+// Run task() like loop() does until the condition is true, false on timeout
+template <typename Condition>
+static bool loopUntil(Condition condition) {
+    unsigned long start = millis();
+    while (!condition()) {
+        if ((millis() - start) > TEST_TIMEOUT_MILLIS) return false;
+        Knx.task();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+// A write is sent by the KNX task, its completion comes back to the application
+static void testTxRoundTrip(void) {
+    CHECK(Knx.write(0, (byte)1) == KNX_DEVICE_OK);
+    KnxTxActionId id = Knx.getLastTxActionId();
+    CHECK(id);
+    CHECK(loopUntil([id] { return completions[id & 0xFF] != 0; }));
+    CHECK(completions[id & 0xFF] == 1);
+    CHECK(completionOutcome[id & 0xFF] == KNX_TX_ACKED);
+    CHECK(tpuartSimLastTarget() == TEST_GA);
+}
+
+// A telegram received by the KNX task is dispatched to knxEvents() by task()
+static void testRxRoundTrip(void) {
+    KnxTelegram telegram;
+    byte payload[14];
+    for (byte i = 0; i < sizeof(payload); i++) payload[i] = 0xA0 + i;
+    telegram.setSourceAddress(P_ADDR(1, 1, 200));
+    telegram.setTargetAddress(G_ADDR(15, 7, 255));  // prog com obj
+    telegram.setCommand(KNX_COMMAND_VALUE_RESPONSE);
+    telegram.setPayloadLength(15);
+    telegram.setLongPayload(payload, sizeof(payload));
+    telegram.updateChecksum();
+    byte raw[KNX_TELEGRAM_MAX_SIZE];
+    for (byte i = 0; i < telegram.getTelegramLength(); i++) raw[i] = telegram.readRawByte(i);
+    tpuartSimInject(raw, telegram.getTelegramLength());
+
+    CHECK(loopUntil([] { return progEvents != 0; }));
+    CHECK(progEvents == 1);
+    CHECK(memcmp(progValue, payload, sizeof(payload)) == 0);
+}
+
+// Each id handed out by write() gets exactly one completion, also when the KNX task has to drop the action
+static void testTxQueueFull(void) {
+    Knx.setTxQueueOverwrite(false);
+    Knx.setWriteCoalescing(false);
+    tpuartSimHoldConfirms(true);  // the first telegram stays in transmission, the next ones fill the TX queue
+
+    KnxTxActionId firstId = Knx.getLastTxActionId() + 1;
+    int accepted = 0;
+    for (int i = 0; i < 3 * ACTIONS_QUEUE_SIZE; i++) {
+        if (Knx.write(1, (byte)i) == KNX_DEVICE_OK) accepted++;
+        Knx.task();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(accepted > ACTIONS_QUEUE_SIZE + 1);
+    KnxTxActionId lastId = Knx.getLastTxActionId();
+    tpuartSimHoldConfirms(false);
+
+    CHECK(loopUntil([firstId, lastId] {
+        for (KnxTxActionId id = firstId; id <= lastId; id++) {
+            if (!completions[id & 0xFF]) return false;
+        }
+        return true;
+    }));
+    int dropped = 0;
+    for (KnxTxActionId id = firstId; id <= lastId; id++) {
+        CHECK(completions[id & 0xFF] == 1);
+        if (completionOutcome[id & 0xFF] == KNX_TX_DROPPED) dropped++;
+    }
+    CHECK(dropped > 0);
+    CHECK(Knx.getRtosCompletionOverflowNb() == 0);
+}
+
+int main(void) {
+    Knx.setComObjectAddress(0, TEST_GA);
+    Knx.setComObjectAddress(1, G_ADDR(1, 2, 4));
+    CHECK(Knx.begin(Serial, P_ADDR(1, 1, 1)) == KNX_DEVICE_OK);
+    Knx.setTxCompletionCallback(&onTxCompletion);
+
+    CHECK(Knx.startRtosTask());
+    CHECK(Knx.isRtosTaskRunning());
+    CHECK(!Knx.startRtosTask());  // runs already
+
+    testTxRoundTrip();
+    testRxRoundTrip();
+    testTxQueueFull();
+
+    Knx.stopRtosTask();
+    CHECK(!Knx.isRtosTaskRunning());
+    Knx.end();
+
+    printf("rtos_test: OK (%u telegrams sent)\n", tpuartSimSentTelegrams());
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "KnxAddressIndex.h"
+#include "DebugUtil.h"
+
+// multiplicative hashing, 40503 = 2^16 / golden ratio
+#define KNX_ADDRESS_INDEX_HASH_FACTOR 40503u
+
+KnxAddressIndex::KnxAddressIndex() {
+    _addresses = NULL;
+    _addressNb = 0;
+    _slots = NULL;
+    _slotMask = 0;
+    _slotShift = 16;
+    _rangeStart = NULL;
+    _comObjects = NULL;
+#ifdef KNX_ADDRESS_INDEX_BITMAP
+    _bitmap = NULL;
+#endif
+}
+
+KnxAddressIndex::~KnxAddressIndex() {
+    clear();
+}
+
+void KnxAddressIndex::clear(void) {
+    free(_slots);
+    free(_rangeStart);
+    free(_comObjects);
+    _slots = NULL;
+    _rangeStart = NULL;
+    _comObjects = NULL;
+#ifdef KNX_ADDRESS_INDEX_BITMAP
+    free(_bitmap);
+    _bitmap = NULL;
+#endif
+    _addresses = NULL;
+    _addressNb = 0;
+    _slotMask = 0;
+    _slotShift = 16;
+}
+
+void KnxAddressIndex::build(const word addresses[], byte addressNb, const byte gaIds[], const byte coIds[], byte assocNb) {
+    clear();
+    if (!addresses || !addressNb) return;
+
+    // hash table size: power of two, at least twice the nb of addresses (max. 512 slots)
+    word slotNb = 2;
+    _slotShift = 15;
+    while (slotNb < 2 * (word)addressNb) {
+        slotNb <<= 1;
+        _slotShift--;
+    }
+
+    _slots = (byte *)calloc(slotNb, sizeof(byte));
+    _rangeStart = (byte *)calloc(addressNb + 1, sizeof(byte));
+    _comObjects = (byte *)malloc(assocNb ? assocNb : 1);
+    if (!_slots || !_rangeStart || !_comObjects) {
+        DEBUG_PRINTLN(F("KnxAddressIndex: out of memory!"));
+        clear();
+        return;
+    }
+    _addresses = addresses;
+    _addressNb = addressNb;
+    _slotMask = slotNb - 1;
+
+    // hash table: GA -> address id (the first one in case of duplicates)
+    for (byte id = 0; id < addressNb; id++) {
+        if (findAddressId(addresses[id]) >= 0) continue;
+        word slot = hash(addresses[id]);
+        while (_slots[slot]) slot = (slot + 1) & _slotMask;
+        _slots[slot] = id + 1;
+    }
+
+    // count the com objects per address id ...
+    // the associations of a duplicate GA are merged into the range of its first address id
+    for (byte i = 0; i < assocNb; i++) {
+        if (gaIds[i] < addressNb) _rangeStart[findAddressId(addresses[gaIds[i]]) + 1]++;
+    }
+    // ... turn the counts into start offsets ...
+    for (byte id = 0; id < addressNb; id++) {
+        _rangeStart[id + 1] += _rangeStart[id];
+    }
+    // ... and fill the ranges, keeping the association table order.
+    // _rangeStart[id] is used as write cursor, afterwards it points to the start of the next id
+    for (byte i = 0; i < assocNb; i++) {
+        if (gaIds[i] < addressNb) _comObjects[_rangeStart[findAddressId(addresses[gaIds[i]])]++] = coIds[i];
+    }
+    for (byte id = addressNb; id > 0; id--) {
+        _rangeStart[id] = _rangeStart[id - 1];
+    }
+    _rangeStart[0] = 0;
+
+#ifdef KNX_ADDRESS_INDEX_BITMAP
+    _bitmap = (byte *)calloc(8192, sizeof(byte));
+    if (_bitmap) {
+        for (byte id = 0; id < addressNb; id++) {
+            if (_rangeStart[id + 1] > _rangeStart[id]) {
+                _bitmap[addresses[id] >> 3] |= (1 << (addresses[id] & 0x07));
+            }
+        }
+    } else {
+        DEBUG_PRINTLN(F("KnxAddressIndex: no memory for bitmap, using hash table only"));
+    }
+#endif
+}
+
+inline word KnxAddressIndex::hash(word ga) const {
+    return (word)(ga * KNX_ADDRESS_INDEX_HASH_FACTOR) >> _slotShift;
+}
+
+int KnxAddressIndex::findAddressId(word ga) const {
+    if (!_slots) return -1;
+    word slot = hash(ga);
+    while (_slots[slot]) {
+        byte id = _slots[slot] - 1;
+        if (_addresses[id] == ga) return id;
+        slot = (slot + 1) & _slotMask;
+    }
+    return -1;
+}
+
+boolean KnxAddressIndex::contains(word ga) const {
+#ifdef KNX_ADDRESS_INDEX_BITMAP
+    if (_bitmap) return (_bitmap[ga >> 3] >> (ga & 0x07)) & 0x01;
+#endif
+    int id = findAddressId(ga);
+    return (id >= 0) && (_rangeStart[id + 1] > _rangeStart[id]);
+}
+
+byte KnxAddressIndex::find(word ga, byte *&list) const {
+#ifdef KNX_ADDRESS_INDEX_BITMAP
+    if (_bitmap && !((_bitmap[ga >> 3] >> (ga & 0x07)) & 0x01)) return 0;
+#endif
+    int id = findAddressId(ga);
+    if (id < 0) return 0;
+    list = &_comObjects[_rangeStart[id]];
+    return _rangeStart[id + 1] - _rangeStart[id];
+}
@@ -0,0 +1,96 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KNXADDRESSINDEX_H
+#define KNXADDRESSINDEX_H
+
+#include "Arduino.h"
+#include "System.h"
+
+// !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
+// -DKNX_ADDRESS_INDEX_BITMAP adds a bitmap with one bit per group address (8kB of heap),
+// which answers "is this GA assigned?" with a single bit test instead of a hash probe.
+// Only worth it on systems with plenty of RAM (f.i. ESP32) and busy lines. The flag has to
+// apply to the library sources as well (build flag, not a #define in the sketch).
+
+/**
+ * Lookup index "group address -> com objects", built once from the address
+ * and association tables.
+ *
+ * The com object indexes are stored grouped by address id (compressed sparse
+ * rows), so all com objects associated to a GA form one contiguous range.
+ * The address id of a GA is found with an open addressing hash table which
+ * is at most half full, so a lookup needs ~1 probe whatever the table sizes are.
+ * If a GA is several times in the address table, its associations are merged.
+ */
+class KnxAddressIndex {
+    const word *_addresses;   // address table (GA per address id), not owned
+    byte _addressNb;          // nb of entries in the address table
+    byte *_slots;             // hash slots: address id + 1, 0 = empty
+    word _slotMask;           // nb of slots - 1 (nb of slots is a power of two)
+    byte _slotShift;          // 16 - log2(nb of slots)
+    byte *_rangeStart;        // per address id: first entry in _comObjects (_addressNb + 1 entries)
+    byte *_comObjects;        // com object indexes, grouped by address id
+#ifdef KNX_ADDRESS_INDEX_BITMAP
+    byte *_bitmap;            // one bit per group address
+#endif
+
+    // Slot to start probing at for the given GA
+    word hash(word ga) const;
+
+    // Address id of the given GA, or -1 if not in the address table
+    int findAddressId(word ga) const;
+
+  public:
+
+    KnxAddressIndex();
+    ~KnxAddressIndex();
+
+    /**
+     * (Re)build the index
+     * The lists returned by find() before are invalid afterwards, so the KNX device must be stopped
+     * (no received telegram queued) while the index is rebuilt
+     * @param addresses address table, has to stay valid as long as the index is used
+     * @param addressNb nb of entries in the address table
+     * @param gaIds association table, address id column
+     * @param coIds association table, com object index column
+     * @param assocNb nb of entries in the association table
+     */
+    void build(const word addresses[], byte addressNb, const byte gaIds[], const byte coIds[], byte assocNb);
+
+    /**
+     * Free the index, all lookups fail afterwards
+     */
+    void clear(void);
+
+    /**
+     * Check if at least one com object is associated to the given GA
+     * @param ga group address
+     * @return true if the GA is assigned
+     */
+    boolean contains(word ga) const;
+
+    /**
+     * Get the com objects associated to the given GA
+     * @param ga group address
+     * @param list set to the first of the associated com object indexes (valid until next build())
+     * @return nb of associated com objects, 0 if the GA is not assigned
+     */
+    byte find(word ga, byte *&list) const;
+};
+
+#endif // KNXADDRESSINDEX_H
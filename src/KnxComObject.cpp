@@ -34,6 +34,13 @@
 #include <DebugUtil.h>
 #include "KnxComObject.h"
 
+#if defined(KNX_COMOBJ_VALUE_ARENA_SIZE)
+// Default value arena, replaced by the one of the sketch if it uses KNX_COMOBJ_VALUE_ARENA()
+__attribute__((weak)) byte KnxComObject::_valueArena[KNX_COMOBJ_VALUE_ARENA_SIZE];
+__attribute__((weak)) word KnxComObject::_valueArenaSize = sizeof(KnxComObject::_valueArena);
+#endif
+word KnxComObject::_valueArenaUsed = 0;
+
 /**
  * Calculates telegram data length based on DPT
  * @param dptId
@@ -47,9 +54,21 @@ byte calcLength(KnxDpt dptId) {
  * Contructor
  * @param dptId
  * @param indicator
+ * @param priority
  */
-KnxComObject::KnxComObject(KnxDpt dptId, byte indicator)
-: _dptId(dptId), _indicator(indicator), _dataLength(calcLength(dptId)) {
+KnxComObject::KnxComObject(KnxDpt dptId, byte indicator, e_KnxPriority priority)
+: KnxComObject(dptId, indicator, priority, calcLength(dptId)) {
+}
+
+/**
+ * Contructor
+ * @param dptId
+ * @param indicator
+ * @param priority
+ * @param length data length of the DPT
+ */
+KnxComObject::KnxComObject(KnxDpt dptId, byte indicator, e_KnxPriority priority, byte length)
+: _dptId(dptId), _indicator((indicator & KNX_COM_OBJ_INDICATOR_MASK) | ((priority << 4) & KNX_COM_OBJ_PRIORITY_MASK)), _dataLength(length) {
         
     if (_indicator & KNX_COM_OBJ_I_INDICATOR) {
         // Object with "InitRead" indicator
@@ -59,25 +78,33 @@ KnxComObject::KnxComObject(KnxDpt dptId, byte indicator)
         _validated = true; 
     }
     
+    _active = false;
+    _decoded = false;
+
     if (_dataLength <= 2) {
-        _longValue = NULL; 
+        _valueOffset = 0;
     } else { 
         // long value case
-        _longValue = (byte *) malloc(_dataLength - 1);
-        for (byte i = 0; i < _dataLength - 1; i++) {
-            _longValue[i] = 0;
-        }
+        // The com objs are static objects, the arena is zeroed before any constructor runs
+        byte size = _dataLength - 1;
+        // If the arena is too small, the need is still counted and begin() fails: the offset only has
+        // to stay within the arena until then
+        _valueOffset = (_valueArenaUsed + size <= _valueArenaSize) ? _valueArenaUsed : 0;
+        _valueArenaUsed += size;
     }
     
 }
 
-/**
- * Destructor
- */
-KnxComObject::~KnxComObject() {
-    if (_dataLength > 2) {
-        free(_longValue);
-    }
+word KnxComObject::getValueArenaUsed(void) {
+    return _valueArenaUsed;
+}
+
+word KnxComObject::getValueArenaSize(void) {
+    return _valueArenaSize;
+}
+
+bool KnxComObject::isValueStorageOk(void) {
+    return _valueArenaUsed <= _valueArenaSize;
 }
 
 /**
@@ -98,7 +125,7 @@ void KnxComObject::getValue(byte value[]) const {
         value[0] = _value; // short value case, ReadValue(void) fct should rather be used
     } else {
         for (byte i = 0; i < _dataLength - 1; i++) {
-            value[i] = _longValue[i]; // long value case
+            value[i] = getLongValue()[i]; // long value case
         }
     }
 }
@@ -112,10 +139,11 @@ void KnxComObject::updateValue(const byte other[]) {
         _value = other[0]; // short value case, UpdateValue(byte) fct should rather be used
     } else {
         for (byte i = 0; i < _dataLength - 1; i++) {
-            _longValue[i] = other[i]; // long value case
+            getLongValue()[i] = other[i]; // long value case
         }
     }
     _validated = true; 
+    _decoded = false;
 }
 
 /**
@@ -137,10 +165,11 @@ byte KnxComObject::updateValue(const KnxTelegram& other) {
             other.getLongPayload(&_value, 1);
             break;
         default:
-            other.getLongPayload(_longValue, _dataLength - 1);
+            other.getLongPayload(getLongValue(), _dataLength - 1);
     }    
     
     _validated = true; // com object set to valid
+    _decoded = false;
     return KNX_COM_OBJECT_OK;
 }
 
@@ -167,6 +196,6 @@ void KnxComObject::copyValue(KnxTelegram& dest) const {
             dest.setLongPayload(&_value, 1);
             break;
         default:
-            dest.setLongPayload(_longValue, _dataLength - 1);
+            dest.setLongPayload(getLongValue(), _dataLength - 1);
     }    
 }
\ No newline at end of file
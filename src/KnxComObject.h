@@ -19,23 +19,45 @@
 #define KNXCOMOBJECT_H
 
 #include "KnxDataPointTypes.h"
+#include "KnxDptCodec.h"
 #include "KnxTelegram.h"
 #include "DebugUtil.h"
+#include "System.h"
 
 // !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
+// Size (bytes) of the static arena the values of long com objs (length > 2) are taken from, in declaration order.
+// KnxDevice::begin() fails if they do not fit. The sketch defines the arena next to the com obj list:
+//   KNX_COMOBJ_VALUE_ARENA(knxValueArenaSize(KNX_DPT_9_001, KNX_DPT_16_000));
+// knxValueArenaSize() computes the need of the listed DPTs at compile time (see KnxDataPointTypes.h),
+// the prog com obj is added by KNX_COMOBJ_VALUE_ARENA().
+// On SIMPLE systems (AVR) the definition is mandatory, the link fails without it (undefined KnxComObject::_valueArenaSize),
+// so that no RAM is spent on a default arena. On DEFAULT systems the library defines a default arena
+// unless the sketch does, its size can be set by a build flag (e.g. -DKNX_COMOBJ_VALUE_ARENA_SIZE=128),
+// which has to apply to the library sources as well.
+#if defined(KONNEKTING_SYSTEM_TYPE_DEFAULT) && !defined(KNX_COMOBJ_VALUE_ARENA_SIZE)
+#define KNX_COMOBJ_VALUE_ARENA_SIZE 512
+#endif
+
+// Defines the value arena in the sketch, with room for size bytes of com obj values besides the prog com obj
+#define KNX_COMOBJ_VALUE_ARENA(size) \
+    byte KnxComObject::_valueArena[(size) + knxDptArenaSize(KNX_DPT_60000_60000)]; \
+    word KnxComObject::_valueArenaSize = sizeof(KnxComObject::_valueArena)
 
 // Definition of comobject indicator values
 // See "knx.org" for comobject indicators specification
 // See: https://redaktion.knx-user-forum.de/lexikon/flags/
 // INDICATOR field : B7  B6  B5  B4  B3  B2  B1  B0
-//                   xx  xx   C   R   W   T   U   I
-//                   xx  xx   K   L   S   Ü   A   I
+//                   P   P    C   R   W   T   U   I
+//                   P   P    K   L   S   Ü   A   I
+// PP = Priority, stored internally (see setPriority()), getIndicator() does not return them
 #define KNX_COM_OBJ_C_INDICATOR 0x20  // Communication (C)
 #define KNX_COM_OBJ_R_INDICATOR 0x10  // Read (R)
 #define KNX_COM_OBJ_W_INDICATOR 0x08  // Write (W)
 #define KNX_COM_OBJ_T_INDICATOR 0x04  // Transmit (T)
 #define KNX_COM_OBJ_U_INDICATOR 0x02  // Update (U)
 #define KNX_COM_OBJ_I_INDICATOR 0x01  // Init Read (I)
+#define KNX_COM_OBJ_INDICATOR_MASK 0x3F  // C/R/W/T/U/I indicators
+#define KNX_COM_OBJ_PRIORITY_MASK 0xC0   // Priority bits (e_KnxPriority value << 4)
 
 // Definition of predefined com obj profiles
 // Sensor profile : COM_OBJ_SENSOR
@@ -57,57 +79,87 @@
 
 class KnxComObject {
 
-    // set to active if GA has been set
-    bool _active;
+    // Fields are ordered and packed to keep a com obj within 8 bytes, also on 32 bits targets
 
     /**
      *  Group Address value
      */
     word _addr;
 
+    union {
+        // field used in case of short value (1 byte max width, i.e. length <= 2)
+        byte _value;
+        // field used in case of long value (2 bytes width or more, i.e. length > 2)
+        // offset of the data space taken from the value arena by the constructor
+        word _valueOffset;
+    };
+
     /**
      * DPT
      */
     byte _dptId;
 
     /**
-     * C/R/W/T/U/I indicators
+     * C/R/W/T/U/I indicators, priority in bits 6+7
      */
     byte _indicator;
 
-    /** 
-     * Com object data length is calculated in the same way as telegram payload length
-     * (See "knx.org" telegram specification for more details)
-     */
-    byte _dataLength;
+    // set to active if GA has been set
+    byte _active : 1;
 
     /**
      * _validated: used for "InitRead" typed comobjects:
      *  "false" until the object value is updated
      *  Other typed comobjects get "true" value immediately
      */
-    bool _validated;
+    byte _validated : 1;
 
-    union {
-        // field used in case of short value (1 byte max width, i.e. length <= 2)
-        struct {
-            byte _value;
-            byte _notUSed;
-        };
-        // field used in case of long value (2 bytes width or more, i.e. length > 2)
-        // The data space is allocated dynamically by the constructor
-        byte* _longValue;
-    };
+    /** 
+     * Com object data length is calculated in the same way as telegram payload length
+     * (See "knx.org" telegram specification for more details), max. 15
+     */
+    byte _dataLength : 4;
+
+    // true while the value decoded by KnxDevice::read() is up to date (see KnxDevice::setReadCache())
+    // not a bit field, as KnxDevice::read() sets it from the application while the KNX task may update the value
+    bool _decoded;
+
+    // Value arena shared by all com objs, its size and nb of bytes already taken
+    // Defined by the sketch with KNX_COMOBJ_VALUE_ARENA(), or by the library with KNX_COMOBJ_VALUE_ARENA_SIZE
+    // _valueArenaUsed keeps counting beyond the size, the device does not start then
+    static byte _valueArena[];
+    static word _valueArenaSize;  // not const, so that the library does not fold the size of its default arena
+    static word _valueArenaUsed;
+
+    // Data space of a long value
+    byte* getLongValue(void) const;
+
+   protected:
+    // Constructor with the length of the DPT already known (see KnxTypedComObject)
+    KnxComObject(KnxDpt dptId, byte indicator, e_KnxPriority priority, byte length);
 
    public:
     // Constructor :
-    KnxComObject(KnxDpt dptId, byte indicator);
-
-    // Destructor
-    ~KnxComObject();
+    KnxComObject(KnxDpt dptId, byte indicator, e_KnxPriority priority = KNX_PRIORITY_NORMAL_VALUE);
 
     bool isActive(void);
 
+    /**
+     * Get the nb of bytes needed by the long com objs values
+     * @return nb of bytes, more than getValueArenaSize() if the arena is too small
+     */
+    static word getValueArenaUsed(void);
+
+    /**
+     * Get the size of the value arena (set by KNX_COMOBJ_VALUE_ARENA() or KNX_COMOBJ_VALUE_ARENA_SIZE)
+     */
+    static word getValueArenaSize(void);
+
+    /**
+     * Returns false if the long com objs values do not fit in the arena (KnxDevice::begin() fails then)
+     */
+    static bool isValueStorageOk(void);
+
     // INLINED functions (see definitions later in this file)
     word getAddr(void) const;
 
@@ -124,12 +176,26 @@ class KnxComObject {
 
     e_KnxPriority getPriority(void) const;
 
+    /**
+     * Set the priority of the telegrams sent for this com object
+     * The TX actions of the com object are queued with this priority as well
+     * @param priority
+     */
+    void setPriority(e_KnxPriority priority);
+
     byte getIndicator(void) const;
 
     bool getValidity(void) const;
 
     void setValidity(void);
 
+    /**
+     * Returns false once the value has been updated since setDecoded(true)
+     */
+    bool isDecoded(void) const;
+
+    void setDecoded(bool decoded);
+
     byte getLength(void) const;
 
     /**
@@ -184,8 +250,28 @@ class KnxComObject {
     void copyValue(KnxTelegram& dest) const;
 };
 
+/**
+ * Com object declared with a DPT known at compile time, e.g. in the sketch:
+ * KnxComObject KnxDevice::_comObjectsList[] = {
+ *     KnxTypedComObject<KNX_DPT_9_001, COM_OBJ_SENSOR>(),
+ *     ...
+ * };
+ * The length is resolved at compile time instead of being looked up in flash by the constructor.
+ * It adds no data to KnxComObject, so it is stored as a plain KnxComObject in the list.
+ * Use KnxDevice::read<dpt>()/write<dpt>() to access the value with the DPT codec resolved at compile time.
+ */
+template <KnxDpt dpt, byte indicator, e_KnxPriority priority = KNX_PRIORITY_NORMAL_VALUE>
+class KnxTypedComObject : public KnxComObject {
+   public:
+    KnxTypedComObject() : KnxComObject(dpt, indicator, priority, KnxDptTraits<dpt>::length) {}
+};
+
 // --------------- Definition of the INLINE functions -----------------
 
+inline byte* KnxComObject::getLongValue(void) const {
+    return &_valueArena[_valueOffset];
+}
+
 inline word KnxComObject::getAddr(void) const {
     return _addr;
 }
@@ -196,7 +282,7 @@ inline void KnxComObject::setAddr(word addr) {
 }
 
 inline void KnxComObject::setIndicator(byte indicator) {
-    _indicator = indicator & 0x3F /* mask for bit 0..b5, b6+b7 is not used here*/;
+    _indicator = (_indicator & KNX_COM_OBJ_PRIORITY_MASK) | (indicator & KNX_COM_OBJ_INDICATOR_MASK) /* b6+b7 keep the priority */;
 }
 
 inline byte KnxComObject::getDptId(void) const {
@@ -204,11 +290,15 @@ inline byte KnxComObject::getDptId(void) const {
 }
 
 inline e_KnxPriority KnxComObject::getPriority(void) const {
-    return KNX_PRIORITY_NORMAL_VALUE;
+    return (e_KnxPriority)((_indicator & KNX_COM_OBJ_PRIORITY_MASK) >> 4);
+}
+
+inline void KnxComObject::setPriority(e_KnxPriority priority) {
+    _indicator = (_indicator & KNX_COM_OBJ_INDICATOR_MASK) | ((priority << 4) & KNX_COM_OBJ_PRIORITY_MASK);
 }
 
 inline byte KnxComObject::getIndicator(void) const {
-    return _indicator;
+    return _indicator & KNX_COM_OBJ_INDICATOR_MASK;
 }
 
 inline bool KnxComObject::getValidity(void) const {
@@ -219,6 +309,14 @@ inline void KnxComObject::setValidity(void) {
     _validated = true;
 }
 
+inline bool KnxComObject::isDecoded(void) const {
+    return _decoded;
+}
+
+inline void KnxComObject::setDecoded(bool decoded) {
+    _decoded = decoded;
+}
+
 inline byte KnxComObject::getLength(void) const {
     return _dataLength;
 }
@@ -231,6 +329,7 @@ inline byte KnxComObject::updateValue(byte newValue) {
     if (_dataLength > 2) return KNX_COM_OBJECT_ERROR;
     _value = newValue;
     _validated = true;
+    _decoded = false;
     return KNX_COM_OBJECT_OK;
 }
 
@@ -260,7 +260,7 @@ enum KnxDpt {
  * Mapping-Table:
  * KnxDptFormat -> it's length in bits
  */
-const byte KnxDptFormatToLength[] PROGMEM = {
+constexpr byte KnxDptFormatToLength[] PROGMEM = {
   1 , //  KNX_DPT_FORMAT_B1 = 0,
   2 , //  KNX_DPT_FORMAT_B2,
   4 , //  KNX_DPT_FORMAT_B1U3
@@ -332,7 +332,7 @@ const byte KnxDptFormatToLength[] PROGMEM = {
  * Mapping-Table:
  * KnxDpt -> KNX DPT Format
  */
-const byte KnxDptToFormat[] PROGMEM = {
+constexpr byte KnxDptToFormat[] PROGMEM = {
   KNX_DPT_FORMAT_B1, //  KNX_DPT_1_000, // 1.000 B1 general bool
   KNX_DPT_FORMAT_B1, //  KNX_DPT_1_001, // 1.001 B1 DPT_Switch
   KNX_DPT_FORMAT_B1, //  KNX_DPT_1_002, // 1.002 B1 DPT_Bool
@@ -457,4 +457,37 @@ const byte KnxDptToFormat[] PROGMEM = {
   KNX_DPT_FORMAT_A112 //  KNX_DPT_60000_60000// 60000.60000 A112 DPT_KONNEKTING_PROGRAM
 };
 
+/**
+ * Telegram data length of a DPT, computed at compile time
+ * Only for constant expressions: at runtime, the tables above must be read with pgm_read_byte()
+ * @param dptId
+ * @return length in bytes (payload length, as for KnxComObject::getLength())
+ */
+constexpr byte knxDptLength(KnxDpt dptId) {
+    return (KnxDptFormatToLength[KnxDptToFormat[dptId]] / 8) + 1;
+}
+
+/**
+ * Nb of bytes a com obj of the given DPT takes from the value arena (see KnxComObject.h)
+ * Short values (length <= 2) are stored in the com obj itself
+ * @param dptId
+ */
+constexpr byte knxDptArenaSize(KnxDpt dptId) {
+    return (knxDptLength(dptId) > 2) ? knxDptLength(dptId) - 1 : 0;
+}
+
+/**
+ * Size of the value arena needed by a list of com objs, computed at compile time
+ * e.g. KNX_COMOBJ_VALUE_ARENA(knxValueArenaSize(KNX_DPT_9_001, KNX_DPT_16_000)); in the sketch (see KnxComObject.h)
+ * The prog com obj (KNX_DPT_60000_60000) is taken from the arena as well, KNX_COMOBJ_VALUE_ARENA() adds it.
+ */
+constexpr word knxValueArenaSize(void) {
+    return 0;
+}
+
+template<typename... Dpts>
+constexpr word knxValueArenaSize(KnxDpt dptId, Dpts... dptIds) {
+    return knxDptArenaSize(dptId) + knxValueArenaSize(dptIds...);
+}
+
 #endif // KNXDATAPOINTTYPES_H
@@ -28,10 +28,6 @@
 #include "KnxDevice.h"
 #include "KonnektingDevice.h"
 
-static inline word TimeDeltaWord(word now, word before) {
-    return (word)(now - before);
-}
-
 // KnxDevice unique instance creation
 KnxDevice KnxDevice::Knx;
 KnxDevice& Knx = KnxDevice::Knx;
@@ -41,10 +37,57 @@ KnxDevice& Knx = KnxDevice::Knx;
 KnxDevice::KnxDevice() {
     _state = INIT;
     _tpuart = NULL;
-    _txActionList = RingBuff<TxAction, ACTIONS_QUEUE_SIZE>();
+    _txActionList = PrioQueue<TxAction, ACTIONS_QUEUE_SIZE, TX_PRIORITY_LEVELS>(TX_PRIORITY_AGING_LIMIT);
     _initCompleted = false;
     _initIndex = 0;
-    _rxTelegram = NULL;
+    for (byte s = 0; s < KNX_INIT_READ_WINDOW; s++) _initReadIndex[s] = 0xFF;
+    _busTelegramsNb = 0;
+    _lastBusTelegramMillis = 0;
+    _rxIsrMode = false;
+    _rxByteBudget = KNX_RX_BYTE_BUDGET;
+    _txBurstMode = false;
+    _txRetryPolicy.maxAttempts = 1;
+    _txRetryPolicy.backoffMillis = 100;
+    _txRetryPolicy.maxBackoffMillis = 2000;
+    _txRetryPolicy.adaptiveAckTimeout = false;
+    _txAttempts = 0;
+    _txRetryPending = false;
+    _txRetryTimeMillis = 0;
+    _txAckTimeout = KNX_TX_ACK_TIMEOUT;
+    _txConfirmLatencyAvg = 0;
+    _txConfirmLatencyDev = 0;
+    for (byte i = 0; i <= TPUART_RESET_RESPONSE; i++) _txAckNb[i] = 0;
+    _txRetriesNb = 0;
+    _txFailedNb = 0;
+    _lastTxActionId = 0;
+    _txActionId = 0;
+    _txActionIndex = 0;
+    _txActionQueueLatency = 0;
+    _txActionStartMicros = 0;
+    _txCompletionCallback = NULL;
+    _txExpiredActionsNb = 0;
+    _cyclicTickTimeMillis = 0;
+    _changeFilters = NULL;
+    _readCaches = NULL;
+    _filteredWritesNb = 0;
+    _comObjHandlers = NULL;
+    _rxWakeCallback = NULL;
+    _txQueueOverwrite = true;
+    _txQueueHighWatermark = 0;
+    _txDroppedActionsNb = 0;
+    _writeCoalescing = false;
+    _coalescedWritesNb = 0;
+    _valueUpdateNb = 0;
+#if defined(KNX_RTOS_TASK)
+    _valueSeq = 0;
+    _rtosRunning = false;
+    _rtosStop = false;
+    _rtosCompletionOverflowNb = 0;
+#endif
+    _maxEventsPerTask = 0;
+    _eventQueueOverflowNb = 0;
+    _progEventDispatching = false;
+    for (byte w = 0; w < KNX_DIRTY_WORDS; w++) _dirty[w] = 0;
 
     _progComObj.setAddr(G_ADDR(15, 7, 255));
 }
@@ -59,15 +102,28 @@ int KnxDevice::getNumberOfComObjects() {
  * else return KNX_DEVICE_OK
  */
 KnxDeviceStatus KnxDevice::begin(HardwareSerial& serial, word physicalAddr) {
-    delete _tpuart;  // always safe to delete null ptr
-    _tpuart = new KnxTpUart(serial, physicalAddr, NORMAL);
-    _rxTelegram = &_tpuart->getReceivedTelegram();
+#if defined(KNX_RTOS_TASK)
+    stopRtosTask();  // restarted by the application once configured again
+#endif
+    if (!KnxComObject::isValueStorageOk()) {
+        DEBUG_PRINTLN(F("Com obj value arena too small, %d bytes needed instead of %d!"),
+                      KnxComObject::getValueArenaUsed(), KnxComObject::getValueArenaSize());
+        return KNX_DEVICE_ERROR;
+    }
+    KnxTpUart *tpuart = _tpuart;
+    _tpuart = NULL;  // rxIsr() must not use the old instance anymore
+    delete tpuart;   // always safe to delete null ptr
+    tpuart = new KnxTpUart(serial, physicalAddr, NORMAL);
+    tpuart->setRxIsrMode(_rxIsrMode);
+    tpuart->setRxByteBudget(_rxByteBudget);
+    tpuart->setTxBurstMode(_txBurstMode);
+    tpuart->setAckTimeout(_txAckTimeout);
+    _tpuart = tpuart;
     //delay(10000); // Workaround for init issue with bus-powered arduino
     // the issue is reproduced on one (faulty?) TPUART device only, so remove it for the moment.
     if (_tpuart->reset() != KNX_TPUART_OK) {
         delete (_tpuart);
         _tpuart = NULL;
-        _rxTelegram = NULL;
         DEBUG_PRINTLN(F("Init Error!"));
         return KNX_DEVICE_INIT_ERROR;
     }
@@ -78,8 +134,11 @@ KnxDeviceStatus KnxDevice::begin(HardwareSerial& serial, word physicalAddr) {
     _state = IDLE;
     DEBUG_PRINTLN(F("Init successful"));
     _lastInitTimeMillis = millis();
+    _lastBusTelegramMillis = _lastInitTimeMillis;
+    _busTelegramsNb = _tpuart->getBusTelegramsNb();
     _lastRXTimeMicros = micros();
     _lastTXTimeMicros = _lastRXTimeMicros;
+    _cyclicTickTimeMillis = millis();
 #if defined(KNXDEVICE_DEBUG_INFO)
     _nbOfInits = 0;
 #endif
@@ -90,14 +149,20 @@ KnxDeviceStatus KnxDevice::begin(HardwareSerial& serial, word physicalAddr) {
 void KnxDevice::end() {
     TxAction action;
 
+#if defined(KNX_RTOS_TASK)
+    stopRtosTask();
+#endif
     _state = INIT;
     while (_txActionList.pop(action))
-        ;  // empty ring buffer
+        freeTxAction(action);  // empty action queue
     _initCompleted = false;
     _initIndex = 0;
-    _rxTelegram = NULL;
-    delete (_tpuart);
-    _tpuart = NULL;
+    for (byte s = 0; s < KNX_INIT_READ_WINDOW; s++) _initReadIndex[s] = 0xFF;
+    _txRetryPending = false;
+    _txAttempts = 0;
+    KnxTpUart *tpuart = _tpuart;
+    _tpuart = NULL;  // rxIsr() must not use the instance anymore
+    delete (tpuart);
 }
 
 /** 
@@ -105,47 +170,92 @@ void KnxDevice::end() {
  * This function call shall be placed in the "loop()" Arduino function
  */
 void KnxDevice::task(void) {
+    task(0);
+    Konnekting.warmStartTask();  // may write and commit the memory, so not part of the budgeted task()
+}
+
+/** 
+ * KNX device execution task with a time budget
+ * @param budgetMicros max. time to stay in task() while the TPUART is active, 0 = until it is idle
+ * @return time (in usec) until task() needs to run again, KNX_TASK_NO_DEADLINE if only UART activity needs it
+ */
+unsigned long KnxDevice::task(unsigned long budgetMicros) {
+#if defined(KNX_RTOS_TASK)
+    bool service = !_rtosRunning;  // the KNX stack runs in the KNX task otherwise
+    dispatchTxCompletions();       // left by the KNX task, even once it has been stopped
+#else
+    bool service = true;
+#endif
+    unsigned long delay = service ? serviceTask(budgetMicros) : KNX_TASK_NO_DEADLINE;
+
+    // the application is called once the RX/TX servicing is done
+    if (dispatchComObjEvents()) delay = 0;
+    return delay;
+}
+
+/**
+ * Run the KNX stack: init reads, cyclic transmissions, TPUART RX, TX queue, TPUART TX
+ * Called by task(), or by the KNX task (see startRtosTask())
+ */
+unsigned long KnxDevice::serviceTask(unsigned long budgetMicros) {
     TxAction action;
-    word nowTimeMillis, nowTimeMicros;
+    unsigned long nowTimeMicros;
+    unsigned long startTimeMicros = micros();
+
+#if defined(KNX_RTOS_TASK)
+    // TX actions requested by the application while the KNX task runs
+    takeOverRtosTxActions();
+#endif
 
-    //stay in task() if _tpuart.isActive()
+    //stay in task() if _tpuart.isActive(), as long as the budget allows
     do {
 
         // STEP 1 : Initialize Com Objects having Init Read attribute
-        if (!_initCompleted) {
-            nowTimeMillis = millis();
-            // To avoid KNX bus overloading, we wait for 500 ms between each Init read request
-            if (TimeDeltaWord(nowTimeMillis, _lastInitTimeMillis) > 500) {
-                while (
-                    (_initIndex < _numberOfComObjects) &&
-                    (_comObjectsList[_initIndex].getValidity() || !_comObjectsList[_initIndex].isActive()) /* either valid (=init done or not required) or not-active required to jump to next index */
-                    ) _initIndex++;
-
-                if (_initIndex == _numberOfComObjects) {
-                    _initCompleted = true;  // All the Com Object initialization have been performed
-                } else {                    // Com Object to be initialised has been found
-                    // Add a READ request in the TX action list
-                    action.command = KNX_READ_REQUEST;
-                    action.index = _initIndex;
-                    _txActionList.append(action);
-                    _lastInitTimeMillis = millis();  // Update the timer
+        if (!_initCompleted) initReadTask();
+
+        // STEP 1b : Queue the due cyclic transmissions
+        if (_cyclicWheel.isActive()) {
+            byte ticks = 0;
+            while ((millis() - _cyclicTickTimeMillis) >= KNX_CYCLIC_TICK_MILLIS) {
+                if (++ticks > KNX_TIMER_WHEEL_SLOTS) {  // task() has not been called for long, don't catch up anymore
+                    _cyclicTickTimeMillis = millis();
+                    break;
                 }
+                _cyclicTickTimeMillis += KNX_CYCLIC_TICK_MILLIS;
+                _cyclicWheel.tick(&KnxDevice::cyclicSendExpired);
             }
         }
 
         // STEP 2 : Get new received KNX messages from the TPUART
         // The TPUART RX task is executed every 400 us
         nowTimeMicros = micros();
-        if (TimeDeltaWord(nowTimeMicros, _lastRXTimeMicros) > 400) {
+        if ((nowTimeMicros - _lastRXTimeMicros) > 400) {
             _lastRXTimeMicros = nowTimeMicros;
             _tpuart->rxTask();
             
             // TODO: check for rx_state in tpuart and call rxtask repeatedly until telegram is received?!
         }
 
+        // Handle the telegrams queued by the TPUART RX task
+        while (_tpuart->getReceivedTelegramsNb()) {
+            getTpUartEvents(TPUART_EVENT_RECEIVED_KNX_TELEGRAM);
+            _tpuart->releaseReceivedTelegram();
+        }
+
         // STEP 3 : Send KNX messages following TX actions
-        if (_state == IDLE) {
-            if (_txActionList.pop(action)) { // Data to be transmitted
+        if ((_state == IDLE) && _txRetryPending) {
+            // the current telegram waits for its retry, the other actions have to wait
+            if ((long)(millis() - _txRetryTimeMillis) >= 0) {
+                _txRetryPending = false;
+                _txTelegram.setRepeated();
+                _txTelegram.updateChecksum();
+                sendTxTelegram();
+            }
+        } else if (_state == IDLE) {
+            // Discard the actions which have waited too long (f.i. during a bus outage)
+            bool popped;
+            while ((popped = _txActionList.pop(action)) && isTxActionExpired(action)) expireTxAction(action);
+            if (popped) { // Data to be transmitted
                 
                 //DEBUG_PRINTLN(F("Data to be transmitted index=%d"), action.index);
                 KnxComObject* comObj = (action.index == 255 ? &_progComObj : &_comObjectsList[action.index]);
@@ -161,8 +271,7 @@ void KnxDevice::task(void) {
                             _txTelegram.clearFirstPayloadByte(); // Is it required to have a clean payload ??
                             _txTelegram.setCommand(KNX_COMMAND_VALUE_READ);
                             _txTelegram.updateChecksum();
-                            _tpuart->sendTelegram(_txTelegram);
-                            _state = TX_ONGOING;
+                            startTxAction(action);
                             break;
 
                     case KNX_RESPONSE_REQUEST: // a response operation of a Com Object on the KNX network is required
@@ -170,8 +279,7 @@ void KnxDevice::task(void) {
                         comObj->copyValue(_txTelegram);
                         _txTelegram.setCommand(KNX_COMMAND_VALUE_RESPONSE);
                         _txTelegram.updateChecksum();
-                        _tpuart->sendTelegram(_txTelegram);
-                        _state = TX_ONGOING;
+                        startTxAction(action);
                         break;
 
                     case KNX_WRITE_REQUEST: // a write operation of a Com Object on the KNX network is required
@@ -179,6 +287,7 @@ void KnxDevice::task(void) {
                         //DEBUG_PRINTLN(F("KNX_WRITE_REQUEST index=%d"), action.index);
                         
                         
+                        beginValueUpdate();
                         if ((comObj->getLength()) <= 2) {
                             //DEBUG_PRINTLN(F("len <= 2"));
                             comObj->updateValue(action.byteValue);
@@ -187,6 +296,7 @@ void KnxDevice::task(void) {
                             comObj->updateValue(action.valuePtr);
                             free(action.valuePtr);
                         }
+                        endValueUpdate();
                         // transmit the value through KNX network only if the Com Object has transmit attribute
                         if ((comObj->getIndicator()) & KNX_COM_OBJ_T_INDICATOR) {
                             //DEBUG_PRINTLN(F("set tx ongoing"));
@@ -194,8 +304,19 @@ void KnxDevice::task(void) {
                             comObj->copyValue(_txTelegram);
                             _txTelegram.setCommand(KNX_COMMAND_VALUE_WRITE);
                             _txTelegram.updateChecksum();
-                            _tpuart->sendTelegram(_txTelegram);
-                            _state = TX_ONGOING;
+                            startTxAction(action);
+                        } else {
+                            notifyTxCompletion(action.id, action.index, KNX_TX_LOCAL_ONLY, micros() - action.queuedTimeMicros, 0);
+                        }
+                        break;
+
+                    case KNX_CYCLIC_WRITE_REQUEST: // the current value of a Com Object has to be sent
+                        if (comObj->isActive() && ((comObj->getIndicator()) & KNX_COM_OBJ_T_INDICATOR)) {
+                            comObj->copyAttributes(_txTelegram);
+                            comObj->copyValue(_txTelegram);
+                            _txTelegram.setCommand(KNX_COMMAND_VALUE_WRITE);
+                            _txTelegram.updateChecksum();
+                            startTxAction(action);
                         }
                         break;
 
@@ -207,11 +328,164 @@ void KnxDevice::task(void) {
         // STEP 4 : LET THE TP-UART TRANSMIT KNX MESSAGES
         // The TPUART TX task is executed every 800 us
         nowTimeMicros = micros();
-        if (TimeDeltaWord(nowTimeMicros, _lastTXTimeMicros) > 800) {
+        if ((nowTimeMicros - _lastTXTimeMicros) > 800) {
             _lastTXTimeMicros = nowTimeMicros;
             _tpuart->txTask();
         }
-    } while (_tpuart->isActive());
+    } while (_tpuart->isActive() && (!budgetMicros || ((micros() - startTimeMicros) < budgetMicros)));
+
+    return getTaskDelay();
+}
+
+/**
+ * Queue the next init read (com objects with Init attribute)
+ * Up to KNX_INIT_READ_WINDOW reads wait for their response at the same time. A read is done once
+ * the com object has been updated by the response, or after KNX_INIT_READ_TIMEOUT. The next read is
+ * queued once the bus has been idle for KNX_INIT_READ_GAP (responses and other devices' traffic
+ * included), and only when nothing else waits for transmission, so the init phase adapts to the bus load.
+ * The com objects without response are read again in further rounds.
+ */
+void KnxDevice::initReadTask(void) {
+    unsigned long now = millis();
+
+    // observe the bus traffic
+    word busTelegramsNb = _tpuart->getBusTelegramsNb();
+    if (busTelegramsNb != _busTelegramsNb) {
+        _busTelegramsNb = busTelegramsNb;
+        _lastBusTelegramMillis = now;
+    }
+
+    // release the reads answered or timed out
+    byte freeSlot = 0xFF;
+    bool waiting = false;
+    for (byte s = 0; s < KNX_INIT_READ_WINDOW; s++) {
+        byte index = _initReadIndex[s];
+        if (index != 0xFF) {
+            if (!_comObjectsList[index].getValidity() && ((now - _initReadTimeMillis[s]) < KNX_INIT_READ_TIMEOUT)) {
+                waiting = true;
+                continue;
+            }
+            _initReadIndex[s] = 0xFF;
+        }
+        freeSlot = s;
+    }
+    if (freeSlot == 0xFF) return;  // window full
+
+    while (
+        (_initIndex < _numberOfComObjects) &&
+        (_comObjectsList[_initIndex].getValidity() || !_comObjectsList[_initIndex].isActive()) /* either valid (=init done or not required) or not-active required to jump to next index */
+        ) _initIndex++;
+
+    if (_initIndex == _numberOfComObjects) {
+        if (waiting) return;  // end of the round, wait for the last responses
+        byte index;
+        for (index = 0; index < _numberOfComObjects; index++) {
+            if (!_comObjectsList[index].getValidity() && _comObjectsList[index].isActive()) break;
+        }
+        if (index == _numberOfComObjects) {
+            _initCompleted = true;  // All the Com Object initialization have been performed
+        } else if ((now - _lastInitTimeMillis) >= KNX_INIT_READ_ROUND_DELAY) {
+            _initIndex = index;  // read again the com objects without response
+        }
+        return;
+    }
+
+    // wait for an idle bus and an empty TX queue
+    if (((now - _lastInitTimeMillis) < KNX_INIT_READ_GAP) || ((now - _lastBusTelegramMillis) < KNX_INIT_READ_GAP)) return;
+    if ((_state != IDLE) || _txRetryPending || _txActionList.getItemCount()) return;
+
+    // Add a READ request in the TX action list
+    TxAction action;
+    action.command = KNX_READ_REQUEST;
+    action.index = _initIndex;
+    action.id = 0;
+    action.expiryTimeMillis = 0;
+    queueTxAction(action);
+    _initReadIndex[freeSlot] = _initIndex;
+    _initReadTimeMillis[freeSlot] = now;
+    _initIndex++;
+    _lastInitTimeMillis = now;
+}
+
+/**
+ * Time (in msec) until initReadTask() has something to do: queue the next init read, release a timed out read,
+ * or start a new round (the responses wake task() up anyway)
+ */
+unsigned long KnxDevice::getInitReadDelay(void) const {
+    unsigned long now = millis();
+    unsigned long delay = KNX_INIT_READ_TIMEOUT;
+    unsigned long elapsed;
+    bool waiting = false;
+    bool windowFull = true;
+
+    for (byte s = 0; s < KNX_INIT_READ_WINDOW; s++) {
+        if (_initReadIndex[s] == 0xFF) {
+            windowFull = false;
+            continue;
+        }
+        waiting = true;
+        elapsed = now - _initReadTimeMillis[s];
+        if (elapsed >= KNX_INIT_READ_TIMEOUT) return 0;
+        delay = min(delay, KNX_INIT_READ_TIMEOUT - elapsed);
+    }
+    if (windowFull) return delay;
+
+    if (_initIndex < _numberOfComObjects) {
+        // next read once the bus is idle, the TX path wakes us up if it is busy
+        if ((_state != IDLE) || _txRetryPending || _txActionList.getItemCount()) return delay;
+        unsigned long last = ((long)(_lastBusTelegramMillis - _lastInitTimeMillis) > 0) ? _lastBusTelegramMillis : _lastInitTimeMillis;
+        elapsed = now - last;
+        return (elapsed >= KNX_INIT_READ_GAP) ? 0 : min(delay, KNX_INIT_READ_GAP - elapsed);
+    }
+    if (waiting) return delay;  // end of the round
+    elapsed = now - _lastInitTimeMillis;
+    return (elapsed >= KNX_INIT_READ_ROUND_DELAY) ? 0 : min(delay, KNX_INIT_READ_ROUND_DELAY - elapsed);
+}
+
+/**
+ * Time (in usec) until task() needs to run again
+ * The earliest of: the next RX/TX slot if the TPUART has work to do, the TPUART EOP/ACK timeout,
+ * the next TX action (retry, queued action), the next init read and the next cyclic transmission tick
+ */
+unsigned long KnxDevice::getTaskDelay(void) {
+    unsigned long nowMicros = micros();
+    unsigned long nowMillis = millis();
+    unsigned long delay = _tpuart->getTaskDelay();
+    unsigned long elapsed;
+
+    if (!delay) {
+        // TPUART work to do, at the next RX or TX slot
+        elapsed = nowMicros - _lastRXTimeMicros;
+        delay = (elapsed > 400) ? 0 : 401 - elapsed;
+        elapsed = nowMicros - _lastTXTimeMicros;
+        if (_tpuart->isActive()) delay = min(delay, (elapsed > 800) ? 0 : 801 - elapsed);
+        if (!delay) return 0;
+    }
+
+    if (_state == IDLE) {
+        if (_txRetryPending) {
+            long retryDelay = (long)(_txRetryTimeMillis - nowMillis);
+            if (retryDelay <= 0) return 0;
+            delay = min(delay, (unsigned long)retryDelay * 1000UL);
+        } else if (_txActionList.getItemCount()) {
+            return 0;
+        }
+    }
+
+    if (!_initCompleted) {
+        unsigned long initDelay = getInitReadDelay();
+        if (!initDelay) return 0;
+        delay = min(delay, initDelay * 1000UL);
+    }
+
+    byte ticks = _cyclicWheel.getTicksToNext();
+    if (ticks) {
+        elapsed = nowMillis - _cyclicTickTimeMillis;
+        unsigned long cyclicDelay = (unsigned long)ticks * KNX_CYCLIC_TICK_MILLIS;
+        if (elapsed >= cyclicDelay) return 0;
+        delay = min(delay, (cyclicDelay - elapsed) * 1000UL);
+    }
+    return delay;
 }
 
 /**
@@ -222,7 +496,8 @@ void KnxDevice::task(void) {
  */
 byte KnxDevice::read(byte objectIndex) {
     //    return _comObjectsList[objectIndex].getValue();
-    return (objectIndex == 255 ? _progComObj.getValue() : _comObjectsList[objectIndex].getValue());
+    if (objectIndex == 255) return (_progEventDispatching ? _progEvent.value[0] : _progComObj.getValue());
+    return _comObjectsList[objectIndex].getValue();
 }
 
 /**
@@ -238,12 +513,46 @@ KnxDeviceStatus KnxDevice::read(byte objectIndex, T& returnedValue) {
         return KNX_DEVICE_OK;
     } else  // long object case, let's see if we are able to translate the DPT value
     {
+        if (_readCaches && (objectIndex != 255) && _readCaches[objectIndex].active) {
+            return readCached(objectIndex, returnedValue);
+        }
         byte dptValue[14];  // define temporary DPT value with max length
-        comObj->getValue(dptValue);
+        word seq;
+        do {
+            seq = beginValueRead();
+            comObj->getValue(dptValue);
+        } while (!endValueRead(seq));
         return ConvertFromDpt(dptValue, returnedValue, pgm_read_byte(&KnxDptToFormat[comObj->getDptId()]));
     }
 }
 
+/**
+ * Read a long com object through its decoded value cache
+ * The value is decoded only if the com object has been updated since the last read
+ */
+template <typename T>
+KnxDeviceStatus KnxDevice::readCached(byte index, T& returnedValue) {
+    KnxComObject* comObj = &_comObjectsList[index];
+    KnxReadCache& cache = _readCaches[index];
+    while (!comObj->isDecoded()) {
+        byte dptValue[14];  // define temporary DPT value with max length
+        word seq = beginValueRead();
+        comObj->getValue(dptValue);
+        KnxDeviceStatus status;
+        if (cache.format == KNX_DPT_FORMAT_F16) status = ConvertFromDpt(dptValue, cache.real, cache.format);
+        else status = ConvertFromDpt(dptValue, cache.integer, cache.format);
+        if (status) return status;
+        comObj->setDecoded(true);
+#if defined(KNX_RTOS_TASK)
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);  // the flag is set before the update check
+#endif
+        if (!endValueRead(seq)) comObj->setDecoded(false);  // updated meanwhile, decode again
+    }
+    if (cache.format == KNX_DPT_FORMAT_F16) returnedValue = (T)cache.real;
+    else returnedValue = (T)cache.integer;
+    return KNX_DEVICE_OK;
+}
+
 template KnxDeviceStatus KnxDevice::read<bool>(byte objectIndex, bool& returnedValue);
 template KnxDeviceStatus KnxDevice::read<byte>(byte objectIndex, byte& returnedValue);
 template KnxDeviceStatus KnxDevice::read<short>(byte objectIndex, short& returnedValue);
@@ -258,8 +567,16 @@ template KnxDeviceStatus KnxDevice::read<double>(byte objectIndex, double& retur
 // Read any type of com object (DPT value provided as is)
 
 KnxDeviceStatus KnxDevice::read(byte objectIndex, byte returnedValue[]) {
+    if ((objectIndex == 255) && _progEventDispatching) {  // payload of the telegram being dispatched
+        memcpy(returnedValue, _progEvent.value, sizeof(_progEvent.value));
+        return KNX_DEVICE_OK;
+    }
     KnxComObject* comObj = (objectIndex == 255 ? &_progComObj : &_comObjectsList[objectIndex]);
-    comObj->getValue(returnedValue);
+    word seq;
+    do {
+        seq = beginValueRead();
+        comObj->getValue(returnedValue);
+    } while (!endValueRead(seq));
     return KNX_DEVICE_OK;
 }
 
@@ -273,11 +590,13 @@ KnxDeviceStatus KnxDevice::read(byte objectIndex, byte returnedValue[]) {
  *              Comobject index
  *  @param value 
  *              the new value
+ *  @param maxAgeMillis
+ *              max. time (ms) the telegram may wait in the TX queue, 0 = no limit
  *  @return KnxDeviceStatus
  */
 /**************************************************************************/
 template <typename T>
-KnxDeviceStatus KnxDevice::write(byte objectIndex, T value) {
+KnxDeviceStatus KnxDevice::write(byte objectIndex, T value, unsigned long maxAgeMillis) {
     TxAction action;
     byte* destValue;
 
@@ -285,12 +604,14 @@ KnxDeviceStatus KnxDevice::write(byte objectIndex, T value) {
     if (!comObj->isActive()) {
         return KNX_DEVICE_COMOBJ_INACTIVE;
     }
+    if (!checkChangeFilter(objectIndex, value)) return KNX_DEVICE_FILTERED;  // value not changed enough
     byte length = comObj->getLength();
 
     if (length <= 2)
         action.byteValue = (byte)value;         // short object case
     else {                                      // long object case, let's try to translate value to the com object DPT
         destValue = (byte*)malloc(length - 1);  // allocate the memory for DPT
+        if (!destValue) return KNX_DEVICE_ERROR;
         KnxDeviceStatus status = ConvertToDpt(value, destValue, pgm_read_byte(&KnxDptToFormat[comObj->getDptId()]));
         if (status)  // translation error
         {
@@ -302,27 +623,30 @@ KnxDeviceStatus KnxDevice::write(byte objectIndex, T value) {
     // add WRITE action in the TX action queue
     action.command = KNX_WRITE_REQUEST;
     action.index = objectIndex;
-    _txActionList.append(action);
-    return KNX_DEVICE_OK;
+    action.expiryTimeMillis = maxAgeMillis;
+    KnxDeviceStatus status = queueRequestedTxAction(action);
+    if (status == KNX_DEVICE_OK) commitChangeFilter(objectIndex, value);  // only once the value is on its way
+    return status;
 }
 
-template KnxDeviceStatus KnxDevice::write<bool>(byte objectIndex, bool value);
-template KnxDeviceStatus KnxDevice::write<byte>(byte objectIndex, byte value);
-template KnxDeviceStatus KnxDevice::write<short>(byte objectIndex, short value);
-template KnxDeviceStatus KnxDevice::write<unsigned short>(byte objectIndex, unsigned short value);
-template KnxDeviceStatus KnxDevice::write<int>(byte objectIndex, int value);
-template KnxDeviceStatus KnxDevice::write<unsigned int>(byte objectIndex, unsigned int value);
-template KnxDeviceStatus KnxDevice::write<long>(byte objectIndex, long value);
-template KnxDeviceStatus KnxDevice::write<unsigned long>(byte objectIndex, unsigned long value);
-template KnxDeviceStatus KnxDevice::write<float>(byte objectIndex, float value);
-template KnxDeviceStatus KnxDevice::write<double>(byte objectIndex, double value);
+template KnxDeviceStatus KnxDevice::write<bool>(byte objectIndex, bool value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<byte>(byte objectIndex, byte value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<short>(byte objectIndex, short value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<unsigned short>(byte objectIndex, unsigned short value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<int>(byte objectIndex, int value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<unsigned int>(byte objectIndex, unsigned int value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<long>(byte objectIndex, long value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<unsigned long>(byte objectIndex, unsigned long value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<float>(byte objectIndex, float value, unsigned long maxAgeMillis);
+template KnxDeviceStatus KnxDevice::write<double>(byte objectIndex, double value, unsigned long maxAgeMillis);
 
 /**
  * Update any type of com object (rough DPT value shall be provided)
  * The Com Object value is updated locally
  * And a telegram is sent on the KNX bus if the com object has communication & transmit attributes
+ * The telegram is not sent anymore once it has waited maxAgeMillis (0 = no limit) in the TX queue
  */
-KnxDeviceStatus KnxDevice::write(byte objectIndex, byte valuePtr[]) {
+KnxDeviceStatus KnxDevice::write(byte objectIndex, byte valuePtr[], unsigned long maxAgeMillis) {
     TxAction action;
 
     // get length of comobj for copying value into tx-action struct
@@ -331,21 +655,24 @@ KnxDeviceStatus KnxDevice::write(byte objectIndex, byte valuePtr[]) {
 
     // check we are in long object case
     if (length > 2) {
+        if (!checkRawChangeFilter(objectIndex, valuePtr, length)) return KNX_DEVICE_FILTERED;  // value not changed
         // add WRITE action in the TX action queue
         action.command = KNX_WRITE_REQUEST;
         action.index = objectIndex;
+        action.expiryTimeMillis = maxAgeMillis;
 
         // allocate the memory for long value
         byte* dptValue = (byte*)malloc(length - 1);
+        if (!dptValue) return KNX_DEVICE_ERROR;
 
         for (byte i = 0; i < length - 1; i++) {
             dptValue[i] = valuePtr[i];  // copy value
         }
         action.valuePtr = (byte*)dptValue;
 
-        _txActionList.append(action);
-
-        return KNX_DEVICE_OK;
+        KnxDeviceStatus status = queueRequestedTxAction(action);
+        if (status == KNX_DEVICE_OK) commitRawChangeFilter(objectIndex, valuePtr, length);
+        return status;
     }
     return KNX_DEVICE_ERROR;
 }
@@ -355,11 +682,275 @@ KnxDeviceStatus KnxDevice::write(byte objectIndex, byte valuePtr[]) {
  * Request the local object to be updated with the value from the bus
  * NB : the function is asynchroneous, the update completion is notified by the knxEvents() callback
  */
-void KnxDevice::update(byte objectIndex) {
+KnxDeviceStatus KnxDevice::update(byte objectIndex) {
     TxAction action;
     action.command = KNX_READ_REQUEST;
     action.index = objectIndex;
-    _txActionList.append(action);
+    action.expiryTimeMillis = 0;
+    return queueRequestedTxAction(action);
+}
+
+/**
+ * Select how the bytes received from the TPUART are collected
+ * @param isrMode true if the application calls rxIsr() from a timer ISR or UART receive callback,
+ *                false if task() collects them
+ */
+void KnxDevice::setRxIsrMode(bool isrMode) {
+    _rxIsrMode = isrMode;
+}
+
+/**
+ * Set the max. nb of received bytes handled by one TPUART RX task execution
+ * @param budget nb of bytes, 1 handles one byte per execution
+ */
+void KnxDevice::setRxByteBudget(byte budget) {
+    _rxByteBudget = budget;
+}
+
+/**
+ * Select how the telegrams are handed over to the TPUART
+ * @param burstMode true to write the whole telegram at once, false to write one byte per TX task execution
+ */
+void KnxDevice::setTxBurstMode(bool burstMode) {
+    _txBurstMode = burstMode;
+}
+
+/**
+ * Get the time (in usec) needed to hand the last sent telegram over to the TPUART
+ */
+unsigned long KnxDevice::getTxHandOverTime(void) const {
+    if (!_tpuart) return 0;
+    return _tpuart->getTxHandOverTime();
+}
+
+/**
+ * Collect the bytes received from the TPUART into the RX ring (RX ISR mode only)
+ * 
+ * DO NOT PUT ANY DEBUG PRINT CODE HERE! It runs in ISR context.
+ */
+void KnxDevice::rxIsr(void) {
+    KnxTpUart *tpuart = _tpuart;
+    if (!_rxIsrMode || !tpuart || !tpuart->rxCollect()) return;
+    if (_rxWakeCallback) _rxWakeCallback();
+#if defined(KNX_RTOS_TASK)
+    if (_rtosRunning) knxRtosSignal(_rtosTask);
+#endif
+}
+
+/**
+ * Set the function called by rxIsr() when bytes have been received
+ * @param callback called in ISR context, NULL = none
+ */
+void KnxDevice::setRxWakeCallback(void (*callback)(void)) {
+    _rxWakeCallback = callback;
+}
+
+/**
+ * Set a send-on-change filter on a com object
+ * @param index com object index
+ * @param absThreshold min. absolute change, 0 = not used
+ * @param relThreshold min. relative change, 0 = not used
+ * @param minIntervalMillis min. time between two passed values
+ * @return KNX_DEVICE_OK, KNX_DEVICE_INVALID_INDEX or KNX_DEVICE_ERROR (out of memory)
+ */
+KnxDeviceStatus KnxDevice::setChangeFilter(byte index, float absThreshold, float relThreshold, word minIntervalMillis) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    if (!_changeFilters) {
+        _changeFilters = (KnxChangeFilter *)calloc(_numberOfComObjects, sizeof(KnxChangeFilter));
+        if (!_changeFilters) return KNX_DEVICE_ERROR;
+    }
+    KnxChangeFilter& filter = _changeFilters[index];
+    filter.absThreshold = fabs(absThreshold);
+    filter.relThreshold = fabs(relThreshold);
+    filter.minIntervalMillis = minIntervalMillis;
+    filter.lastKind = KNX_CHANGE_NONE;
+    filter.active = true;
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Remove the send-on-change filter of a com object
+ */
+KnxDeviceStatus KnxDevice::clearChangeFilter(byte index) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    if (_changeFilters) _changeFilters[index].active = false;
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Get the nb of writes discarded by the send-on-change filters
+ */
+word KnxDevice::getFilteredWritesNb(void) const {
+    return _filteredWritesNb;
+}
+
+/**
+ * Cache the decoded value of a long com object
+ * @param index com object index
+ * @param active false to remove the cache
+ * @return KNX_DEVICE_OK, KNX_DEVICE_INVALID_INDEX or KNX_DEVICE_ERROR (not a long com object, out of memory)
+ */
+KnxDeviceStatus KnxDevice::setReadCache(byte index, bool active) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    if (_comObjectsList[index].getLength() <= 2) return KNX_DEVICE_ERROR;
+    if (!_readCaches) {
+        if (!active) return KNX_DEVICE_OK;
+        _readCaches = (KnxReadCache *)calloc(_numberOfComObjects, sizeof(KnxReadCache));
+        if (!_readCaches) return KNX_DEVICE_ERROR;
+    }
+    _readCaches[index].format = pgm_read_byte(&KnxDptToFormat[_comObjectsList[index].getDptId()]);
+    _readCaches[index].active = active;
+    _comObjectsList[index].setDecoded(false);
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Send the current value of a com object periodically
+ * @param index com object index
+ * @param periodMillis period, 0 stops the cyclic transmission
+ * @return KNX_DEVICE_OK, KNX_DEVICE_INVALID_INDEX or KNX_DEVICE_ERROR (out of memory)
+ */
+KnxDeviceStatus KnxDevice::setCyclicSend(byte index, unsigned long periodMillis) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    if (!_cyclicWheel.isActive()) {
+        if (!periodMillis) return KNX_DEVICE_OK;
+        if (!_cyclicWheel.begin(_numberOfComObjects)) return KNX_DEVICE_ERROR;
+        _cyclicTickTimeMillis = millis();
+    }
+    unsigned long period = (periodMillis + KNX_CYCLIC_TICK_MILLIS / 2) / KNX_CYCLIC_TICK_MILLIS;
+    if (periodMillis && !period) period = 1;
+    if (period > 0xFFFF) period = 0xFFFF;
+    // random phase, to spread the transmissions of the com objects registered at the same time
+    _cyclicWheel.schedule(index, period, period ? 1 + random(period) : 0);
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Get the period (in msec) of the cyclic transmission of a com object
+ */
+unsigned long KnxDevice::getCyclicSend(byte index) const {
+    return (unsigned long)_cyclicWheel.getPeriod(index) * KNX_CYCLIC_TICK_MILLIS;
+}
+
+/**
+ * Get the nb of TX actions discarded because they were older than their max. age
+ */
+word KnxDevice::getTxExpiredActionsNb(void) const {
+    return _txExpiredActionsNb;
+}
+
+/**
+ * Get the id given to the TX action queued by the last successful write() or update() call
+ */
+KnxTxActionId KnxDevice::getLastTxActionId(void) const {
+    return _lastTxActionId;
+}
+
+/**
+ * Set the function called on completion of each TX action requested by the application
+ * @param callback NULL to keep the completions in the completion ring (see getTxCompletion())
+ */
+void KnxDevice::setTxCompletionCallback(void (*callback)(const KnxTxCompletion&)) {
+    _txCompletionCallback = callback;
+}
+
+/**
+ * Get the oldest TX completion not polled yet
+ * @param completion
+ * @return false if there's none
+ */
+bool KnxDevice::getTxCompletion(KnxTxCompletion& completion) {
+#if defined(KNX_RTOS_TASK)
+    if (_rtosCompletionRing.pop(completion)) return true;
+#endif
+    return _txCompletions.pop(completion);
+}
+
+/**
+ * Set the retry policy for telegrams which are not confirmed by the TPUART
+ * @param policy
+ */
+void KnxDevice::setTxRetryPolicy(const KnxTxRetryPolicy& policy) {
+    _txRetryPolicy = policy;
+    if (!_txRetryPolicy.maxAttempts) _txRetryPolicy.maxAttempts = 1;
+    if (!_txRetryPolicy.adaptiveAckTimeout) {
+        _txAckTimeout = KNX_TX_ACK_TIMEOUT;
+        if (_tpuart) _tpuart->setAckTimeout(_txAckTimeout);
+    }
+}
+
+/**
+ * Get the nb of telegram transmissions ended with the given TPUART confirm value
+ */
+word KnxDevice::getTxAckNb(TpUartTxAck ack) const {
+    if (ack > TPUART_RESET_RESPONSE) return 0;
+    return _txAckNb[ack];
+}
+
+/**
+ * Get the nb of telegram retries
+ */
+word KnxDevice::getTxRetriesNb(void) const {
+    return _txRetriesNb;
+}
+
+/**
+ * Get the nb of telegrams given up after the last allowed attempt
+ */
+word KnxDevice::getTxFailedNb(void) const {
+    return _txFailedNb;
+}
+
+/**
+ * Get the current ACK timeout (in msec)
+ */
+word KnxDevice::getTxAckTimeout(void) const {
+    return _txAckTimeout;
+}
+
+/**
+ * Select what happens when a TX action is requested while the TX queue is full
+ * @param overwrite true to drop the oldest least urgent queued action, false to drop the new one
+ */
+void KnxDevice::setTxQueueOverwrite(bool overwrite) {
+    _txQueueOverwrite = overwrite;
+}
+
+/**
+ * Get the max. nb of TX actions queued at the same time
+ */
+byte KnxDevice::getTxQueueHighWatermark(void) const {
+    return _txQueueHighWatermark;
+}
+
+/**
+ * Get the nb of TX actions dropped because the TX queue was full
+ */
+word KnxDevice::getTxDroppedActionsNb(void) const {
+    return _txDroppedActionsNb;
+}
+
+/**
+ * Select if a write replaces the value of a write on the same com object still queued
+ * @param coalescing
+ */
+void KnxDevice::setWriteCoalescing(bool coalescing) {
+    _writeCoalescing = coalescing;
+}
+
+/**
+ * Get the nb of writes merged into a write still queued
+ */
+word KnxDevice::getCoalescedWritesNb(void) const {
+    return _coalescedWritesNb;
+}
+
+/**
+ * Get the nb of received telegrams lost because the RX queue was full
+ */
+word KnxDevice::getRxQueueOverflowNb(void) const {
+    if (!_tpuart) return 0;
+    return _tpuart->getRxQueueOverflowNb();
 }
 
 /**
@@ -368,6 +959,7 @@ void KnxDevice::update(byte objectIndex) {
 bool KnxDevice::isActive() const {
     if (_tpuart->isActive()) return true;           // TPUART is active
     if (_state == TX_ONGOING) return true;          // the Device is sending a request
+    if (_txRetryPending) return true;               // a telegram waits for its retry
     if (_txActionList.getItemCount()) return true;  // there is at least one tx action in the queue
     return false;
 }
@@ -385,10 +977,306 @@ KnxDeviceStatus KnxDevice::setComObjectIndicator(byte index, byte indicator) {
     return KNX_DEVICE_OK;
 }
 
+KnxDeviceStatus KnxDevice::setComObjectPriority(byte index, e_KnxPriority priority) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    _comObjectsList[index].setPriority(priority);
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Set the function called when a com object is updated from the bus
+ * @param index com object index
+ * @param handler NULL to route the updates to knxEvents() again
+ * @param ctx passed to the handler
+ * @return KNX_DEVICE_OK, KNX_DEVICE_INVALID_INDEX or KNX_DEVICE_ERROR (out of memory)
+ */
+KnxDeviceStatus KnxDevice::setComObjectHandler(byte index, KnxComObjectHandler handler, void* ctx) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    if (!_comObjHandlers) {
+        if (!handler) return KNX_DEVICE_OK;
+        _comObjHandlers = (KnxComObjectHandlerEntry *)calloc(_numberOfComObjects, sizeof(KnxComObjectHandlerEntry));
+        if (!_comObjHandlers) return KNX_DEVICE_ERROR;
+    }
+    _comObjHandlers[index].handler = handler;
+    _comObjHandlers[index].ctx = ctx;
+    return KNX_DEVICE_OK;
+}
+
 word KnxDevice::getComObjectAddress(byte index) {
     return _comObjectsList[index].getAddr();
 }
 
+byte KnxDevice::getComObjectIndicator(byte index) {
+    return _comObjectsList[index].getIndicator();
+}
+
+byte KnxDevice::getComObjectLength(byte index) {
+    return _comObjectsList[index].getLength();
+}
+
+bool KnxDevice::isComObjectValid(byte index) {
+    return _comObjectsList[index].getValidity();
+}
+
+/**
+ * Read the value and the validity of a com object within the same value read
+ */
+KnxDeviceStatus KnxDevice::readComObjectState(byte index, byte value[], bool& valid) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    word seq;
+    do {
+        seq = beginValueRead();
+        valid = _comObjectsList[index].getValidity();
+        _comObjectsList[index].getValue(value);
+    } while (!endValueRead(seq));
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Set the value of a com object locally, without telegram, and mark it as initialized
+ */
+KnxDeviceStatus KnxDevice::restoreComObjectValue(byte index, const byte value[]) {
+    if (_state != INIT) return KNX_DEVICE_INIT_ERROR;
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    _comObjectsList[index].updateValue(value);
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Queue a TX action according to the priority of its com object
+ */
+KnxDeviceStatus KnxDevice::queueTxAction(TxAction& action) {
+    stampTxAction(action);
+    return insertTxAction(action);
+}
+
+/**
+ * Set the queueing time of a TX action, and turn the max. age given in expiryTimeMillis into the expiry time
+ */
+void KnxDevice::stampTxAction(TxAction& action) {
+    if (action.expiryTimeMillis) {
+        action.expiryTimeMillis += millis();
+        if (!action.expiryTimeMillis) action.expiryTimeMillis = 1;  // 0 means never
+    }
+    action.queuedTimeMicros = micros();
+}
+
+/**
+ * Queue a stamped TX action according to the priority of its com object
+ */
+KnxDeviceStatus KnxDevice::insertTxAction(TxAction& action) {
+    KnxComObject* comObj = (action.index == 255 ? &_progComObj : &_comObjectsList[action.index]);
+    byte level;
+    switch (comObj->getPriority()) {
+        case KNX_PRIORITY_SYSTEM_VALUE: level = TX_PRIORITY_LEVEL_SYSTEM; break;
+        case KNX_PRIORITY_ALARM_VALUE: level = TX_PRIORITY_LEVEL_ALARM; break;
+        case KNX_PRIORITY_HIGH_VALUE: level = TX_PRIORITY_LEVEL_HIGH; break;
+        default: level = TX_PRIORITY_LEVEL_NORMAL; break;
+    }
+
+    if ((action.command == KNX_WRITE_REQUEST) && coalesceWriteAction(action, level)) return KNX_DEVICE_OK;
+
+    if (_txActionList.isFull()) {
+        _txDroppedActionsNb++;
+        // make space by dropping the oldest action of the least urgent level,
+        // or drop the new action itself if overwriting is disabled or all the queued ones are more urgent
+        TxAction droppedAction;
+        if (!_txQueueOverwrite || !_txActionList.evict(droppedAction, level)) {
+            DEBUG_PRINTLN(F("TX queue full, action on #%d dropped"), action.index);
+            freeTxAction(action);
+            return KNX_DEVICE_TX_QUEUE_FULL;
+        }
+        DEBUG_PRINTLN(F("TX queue full, action on #%d dropped"), droppedAction.index);
+        freeTxAction(droppedAction);
+        notifyTxCompletion(droppedAction.id, droppedAction.index, KNX_TX_DROPPED, action.queuedTimeMicros - droppedAction.queuedTimeMicros, 0);
+    }
+    _txActionList.append(action, level);
+    if (_txActionList.getItemCount() > _txQueueHighWatermark) _txQueueHighWatermark = _txActionList.getItemCount();
+    return KNX_DEVICE_OK;
+}
+
+/**
+ * Queue a TX action requested by the application with a new id
+ * The programming com object actions get no id, they are not notified
+ */
+KnxDeviceStatus KnxDevice::queueRequestedTxAction(TxAction& action) {
+    KnxTxActionId id = 0;
+    if (action.index != 255) {
+        id = _lastTxActionId + 1;
+        if (!id) id = 1;  // 0 means no id
+    }
+    action.id = id;
+#if defined(KNX_RTOS_TASK)
+    if (_rtosRunning) {
+        // hand the action over to the KNX task, it is stamped now so its latency and max. age include the handover
+        stampTxAction(action);
+        if (!_rtosTxRing.push(action)) {
+            freeTxAction(action);
+            return KNX_DEVICE_TX_QUEUE_FULL;
+        }
+        if (id) _lastTxActionId = id;
+        knxRtosSignal(_rtosTask);
+        return KNX_DEVICE_OK;
+    }
+#endif
+    KnxDeviceStatus status = queueTxAction(action);
+    if ((status == KNX_DEVICE_OK) && id) _lastTxActionId = id;
+    return status;
+}
+
+/**
+ * Match function for PrioQueue::find(): write action on the com object index given by ctx
+ */
+static boolean isWriteActionOn(const TxAction& action, const void* ctx) {
+    return (action.command == KNX_WRITE_REQUEST) && (action.index == *(const byte*)ctx);
+}
+
+/**
+ * Match function for PrioQueue::find(): write or cyclic write action on the com object index given by ctx
+ */
+static boolean isValueActionOn(const TxAction& action, const void* ctx) {
+    return ((action.command == KNX_WRITE_REQUEST) || (action.command == KNX_CYCLIC_WRITE_REQUEST)) && (action.index == *(const byte*)ctx);
+}
+
+/**
+ * Replace the value of a write action still queued for the same com object
+ */
+bool KnxDevice::coalesceWriteAction(const TxAction& action, byte level) {
+    if (!_writeCoalescing) return false;
+    if (action.index == 255) return false;  // programming messages must all be sent
+    TxAction* queuedAction = _txActionList.find(level, &isWriteActionOn, &action.index);
+    if (!queuedAction) return false;
+
+    // the queued action keeps its place in the queue, with the new value
+    freeTxAction(*queuedAction);
+    notifyTxCompletion(queuedAction->id, queuedAction->index, KNX_TX_COALESCED, action.queuedTimeMicros - queuedAction->queuedTimeMicros, 0);
+    *queuedAction = action;
+    _coalescedWritesNb++;
+    return true;
+}
+
+/**
+ * Returns true if the TX action is older than its max. age
+ */
+bool KnxDevice::isTxActionExpired(const TxAction& action) const {
+    return action.expiryTimeMillis && ((long)(millis() - action.expiryTimeMillis) >= 0);
+}
+
+/**
+ * Discard an expired TX action
+ * A write still updates the com object value, so read() and read responses give the value last written
+ */
+void KnxDevice::expireTxAction(const TxAction& action) {
+    DEBUG_PRINTLN(F("TX action on #%d expired"), action.index);
+    _txExpiredActionsNb++;
+    if (action.command == KNX_WRITE_REQUEST) {
+        KnxComObject* comObj = (action.index == 255 ? &_progComObj : &_comObjectsList[action.index]);
+        beginValueUpdate();
+        if (comObj->getLength() <= 2) {
+            comObj->updateValue(action.byteValue);
+        } else {
+            comObj->updateValue(action.valuePtr);
+            free(action.valuePtr);
+        }
+        endValueUpdate();
+    }
+    notifyTxCompletion(action.id, action.index, KNX_TX_EXPIRED, micros() - action.queuedTimeMicros, 0);
+}
+
+/**
+ * Free the memory owned by a TX action which is dropped without being performed
+ */
+void KnxDevice::freeTxAction(const TxAction& action) {
+    if (action.command != KNX_WRITE_REQUEST) return;
+    KnxComObject* comObj = (action.index == 255 ? &_progComObj : &_comObjectsList[action.index]);
+    if (comObj->getLength() > 2) free(action.valuePtr);
+}
+
+/**
+ * Send-on-change filter of a com object
+ * @return NULL if the com object has no active filter
+ */
+KnxChangeFilter* KnxDevice::getChangeFilter(byte index) {
+    if (!_changeFilters || (index == 255) || !_changeFilters[index].active) return NULL;
+    return &_changeFilters[index];
+}
+
+/**
+ * Returns true if a numeric value differs enough from the last value passed:
+ * by at least one of the thresholds set, or at all when none is set
+ * @param delta distance to the last value passed, not 0
+ * @param lastValue last value passed, for the relative threshold
+ */
+bool KnxDevice::exceedsThresholds(const KnxChangeFilter& filter, float delta, float lastValue) const {
+    if (!filter.absThreshold && !filter.relThreshold) return true;
+    return ((filter.absThreshold != 0) && (delta >= filter.absThreshold)) ||
+           ((filter.relThreshold != 0) && (delta >= filter.relThreshold * fabs(lastValue)));
+}
+
+/**
+ * Apply the min. interval of a filter to a new value
+ * @param changed false if the value does not differ (enough) from the last value passed
+ * @return true if the value passes
+ */
+bool KnxDevice::checkChange(KnxChangeFilter& filter, bool changed) {
+    if (filter.lastKind == KNX_CHANGE_NONE) return true;  // the first value always passes
+    if (!changed || ((millis() - filter.lastSendMillis) < filter.minIntervalMillis)) {
+        _filteredWritesNb++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Returns true if a raw DPT value differs from the last raw value passed (or if the com object has no filter)
+ */
+bool KnxDevice::checkRawChangeFilter(byte index, const byte value[], byte length) {
+    KnxChangeFilter* filter = getChangeFilter(index);
+    if (!filter) return true;
+    return checkChange(*filter, (filter->lastKind != KNX_CHANGE_RAW) || memcmp(filter->lastRaw, value, length - 1));
+}
+
+/**
+ * Record a raw DPT value which has been queued as the last value passed
+ */
+void KnxDevice::commitRawChangeFilter(byte index, const byte value[], byte length) {
+    KnxChangeFilter* filter = getChangeFilter(index);
+    if (!filter) return;
+    if (!filter->lastRaw) filter->lastRaw = (byte *)malloc(length - 1);  // the length of a com object never changes
+    if (filter->lastRaw) {
+        memcpy(filter->lastRaw, value, length - 1);
+        filter->lastKind = KNX_CHANGE_RAW;
+    } else {
+        filter->lastKind = KNX_CHANGE_NONE;  // out of memory, the next value passes
+    }
+    filter->lastSendMillis = millis();
+}
+
+/**
+ * Queue the cyclic transmission of a com object, unless a write on it is still queued
+ */
+void KnxDevice::queueCyclicWrite(byte index) {
+    KnxComObject* comObj = &_comObjectsList[index];
+    if (!comObj->isActive()) return;
+    byte level;
+    for (level = 0; level < TX_PRIORITY_LEVELS; level++) {
+        if (_txActionList.find(level, &isValueActionOn, &index)) return;  // the value is going to be sent anyway
+    }
+    TxAction action;
+    action.command = KNX_CYCLIC_WRITE_REQUEST;
+    action.index = index;
+    action.id = 0;
+    action.expiryTimeMillis = 0;
+    queueTxAction(action);
+}
+
+/**
+ * Static cyclicSendExpired() function called by _cyclicWheel
+ */
+void KnxDevice::cyclicSendExpired(byte index) {
+    Knx.queueCyclicWrite(index);
+}
+
 /**
  * Static getTpUartEvents() function called by the KnxTpUart layer (callback)
  */
@@ -400,8 +1288,8 @@ void KnxDevice::getTpUartEvents(KnxTpUartEvent event) {
     switch (event) {
         // Manage RECEIVED MESSAGES
         case TPUART_EVENT_RECEIVED_KNX_TELEGRAM: {
-            Knx._state = IDLE;
-
+            // oldest telegram of the TPUART RX queue, released by task() afterwards
+            KnxTelegram& rxTelegram = Knx._tpuart->getReceivedTelegram();
             AddressedComObjects addressedComObjects = Knx._tpuart->getAddressedComObjects();  //.get(0, targetedComObjIndex);
 
             DEBUG_PRINTLN(F("KnxDevice::getTpUartEvents need to process %d comobjs."), addressedComObjects.items);
@@ -412,18 +1300,20 @@ void KnxDevice::getTpUartEvents(KnxTpUartEvent event) {
 
                 KnxComObject* comObj = (targetedComObjIndex == 255 ? &Knx._progComObj : &_comObjectsList[targetedComObjIndex]);
 
-                DEBUG_PRINTLN(F("KnxDevice::getTpUartEvents targetedComObjIndex=%d command=%d"), targetedComObjIndex, Knx._rxTelegram->getCommand());
+                DEBUG_PRINTLN(F("KnxDevice::getTpUartEvents targetedComObjIndex=%d command=%d"), targetedComObjIndex, rxTelegram.getCommand());
 
                 byte indicator = comObj->getIndicator();
 
-                switch (Knx._rxTelegram->getCommand()) {
+                switch (rxTelegram.getCommand()) {
                     case KNX_COMMAND_VALUE_READ:
                         // READ command coming from the bus
                         // if the Com Object has read attribute, then add RESPONSE action in the TX action list
                         if ((comObj->getIndicator()) & KNX_COM_OBJ_R_INDICATOR) {  // The targeted Com Object can indeed be read
                             action.command = KNX_RESPONSE_REQUEST;
                             action.index = targetedComObjIndex;
-                            Knx._txActionList.append(action);
+                            action.id = 0;
+                            action.expiryTimeMillis = 0;
+                            Knx.queueTxAction(action);
                         }
                         break;
 
@@ -431,9 +1321,11 @@ void KnxDevice::getTpUartEvents(KnxTpUartEvent event) {
                         // RESPONSE command coming from KNX network, we update the value of the corresponding Com Object.
                         // We 1st check that the corresponding Com Object has UPDATE attribute
                         if ((comObj->getIndicator()) & KNX_COM_OBJ_U_INDICATOR) {
-                            comObj->updateValue(*(Knx._rxTelegram));
+                            Knx.beginValueUpdate();
+                            comObj->updateValue(rxTelegram);
+                            Knx.endValueUpdate();
                             //We notify the upper layer of the update
-                            knxEvents(targetedComObjIndex);
+                            Knx.comObjEvent(targetedComObjIndex, KNX_COMMAND_VALUE_RESPONSE);
                         }
                         break;
 
@@ -443,15 +1335,11 @@ void KnxDevice::getTpUartEvents(KnxTpUartEvent event) {
 
                         DEBUG_PRINTLN(F("ComObj Indicator=0x%02X"), indicator);
                         if ((indicator)&KNX_COM_OBJ_W_INDICATOR) {
-                            comObj->updateValue(*(Knx._rxTelegram));
+                            Knx.beginValueUpdate();
+                            comObj->updateValue(rxTelegram);
+                            Knx.endValueUpdate();
                             //We notify the upper layer of the update
-                            if (Konnekting.isActive()) {
-                                DEBUG_PRINTLN(F("Routing event to konnektingKnxEvents #%d"), targetedComObjIndex);
-                                konnektingKnxEvents(targetedComObjIndex);
-                            } else {
-                                DEBUG_PRINTLN(F("No event routing, because not active: #%d"), targetedComObjIndex);
-                                //                        knxEvents(targetedComObjIndex);
-                            }
+                            Knx.comObjEvent(targetedComObjIndex, KNX_COMMAND_VALUE_WRITE);
                         } else {
                             DEBUG_PRINTLN(F("Wrong config byte on comobj #%d: 0x%02X"), targetedComObjIndex, indicator);
                         }
@@ -481,8 +1369,365 @@ void KnxDevice::getTpUartEvents(KnxTpUartEvent event) {
 /*
  * Static txTelegramAck() function called by the KnxTpUart layer (callback)
  */
-void KnxDevice::txTelegramAck(TpUartTxAck) {
+void KnxDevice::txTelegramAck(TpUartTxAck value) {
     Knx._state = IDLE;
+    Knx._txAckNb[value]++;
+
+    switch (value) {
+        case ACK_RESPONSE:
+            Knx.updateAckTimeout(Knx._tpuart->getTxConfirmLatency());
+            Knx._txAttempts = 0;
+            Knx.notifyTxCompletion(Knx._txActionId, Knx._txActionIndex, KNX_TX_ACKED,
+                                   Knx._txActionQueueLatency, micros() - Knx._txActionStartMicros);
+            break;
+
+        case NO_ANSWER_TIMEOUT:
+            // the ACK timeout may be too short for the current bus load
+            if (Knx._txRetryPolicy.adaptiveAckTimeout) {
+                Knx._txAckTimeout = min(2 * Knx._txAckTimeout, KNX_TX_ACK_TIMEOUT);
+                Knx._tpuart->setAckTimeout(Knx._txAckTimeout);
+            }
+            Knx.txTelegramFailed(value);
+            break;
+
+        default:  // NACK_RESPONSE, TPUART_RESET_RESPONSE
+            Knx.txTelegramFailed(value);
+            break;
+    }
+}
+
+/**
+ * Start the transmission of the telegram built for a TX action
+ */
+void KnxDevice::startTxAction(const TxAction& action) {
+    _txActionId = action.id;
+    _txActionIndex = action.index;
+    _txActionStartMicros = micros();
+    _txActionQueueLatency = _txActionStartMicros - action.queuedTimeMicros;
+    _txAttempts = 0;
+    sendTxTelegram();
+}
+
+/**
+ * Send _txTelegram, as new telegram or as retry
+ */
+void KnxDevice::sendTxTelegram(void) {
+    _txAttempts++;
+    if (_tpuart->sendTelegram(_txTelegram) == KNX_TPUART_OK) {
+        _state = TX_ONGOING;
+    } else {
+        txTelegramFailed(TPUART_RESET_RESPONSE);  // TPUART TX not available (f.i. reset ongoing)
+    }
+}
+
+/**
+ * Schedule the retry of _txTelegram, or give it up once the max. nb of attempts is reached
+ */
+void KnxDevice::txTelegramFailed(TpUartTxAck outcome) {
+    if (_txAttempts >= _txRetryPolicy.maxAttempts) {
+        if (_txRetryPolicy.maxAttempts > 1) DEBUG_PRINTLN(F("TX failed after %d attempts"), _txAttempts);
+        _txFailedNb++;
+        _txAttempts = 0;
+        notifyTxCompletion(_txActionId, _txActionIndex, (KnxTxOutcome)outcome, _txActionQueueLatency, micros() - _txActionStartMicros);
+        return;
+    }
+    // exponential backoff with jitter, so that devices failing at the same time do not retry at the same time
+    unsigned long backoff = _txRetryPolicy.backoffMillis;
+    for (byte i = 1; (i < _txAttempts) && (backoff < _txRetryPolicy.maxBackoffMillis); i++) backoff <<= 1;
+    if (backoff > _txRetryPolicy.maxBackoffMillis) backoff = _txRetryPolicy.maxBackoffMillis;
+    backoff += random(backoff / 2 + 1);
+
+    _txRetryTimeMillis = millis() + backoff;
+    _txRetryPending = true;
+    _txRetriesNb++;
+}
+
+/**
+ * Notify the completion of a TX action, either with the callback or through the completion ring
+ */
+void KnxDevice::notifyTxCompletion(KnxTxActionId id, byte index, KnxTxOutcome outcome, unsigned long queueLatency, unsigned long busLatency) {
+    if (!id) return;  // internal action
+    KnxTxCompletion completion;
+    completion.id = id;
+    completion.index = index;
+    completion.outcome = outcome;
+    completion.queueLatency = queueLatency;
+    completion.busLatency = busLatency;
+#if defined(KNX_RTOS_TASK)
+    if (_rtosRunning) {
+        // dispatched by task(), in the application context
+        if (!_rtosCompletionRing.push(completion)) _rtosCompletionOverflowNb++;
+        return;
+    }
+#endif
+    if (_txCompletionCallback) _txCompletionCallback(completion);
+    else _txCompletions.append(completion);
+}
+
+/**
+ * Queue a com object update, to be dispatched by task() in the application context
+ * (the RX path and the KNX task never call application code)
+ */
+void KnxDevice::comObjEvent(byte index, byte command) {
+    if ((index < _numberOfComObjects) && (index < KNX_DIRTY_WORDS * 32)) {  // not the prog com obj
+#if defined(KNX_RTOS_TASK)
+        __atomic_fetch_or(&_dirty[index >> 5], (uint32_t)1 << (index & 31), __ATOMIC_RELEASE);
+#else
+        _dirty[index >> 5] |= (uint32_t)1 << (index & 31);
+#endif
+    }
+    if (_eventQueue.isFull() || ((index == 255) && _progEventQueue.isFull())) {
+        DEBUG_PRINTLN(F("Event queue full, event on #%d lost"), index);
+        _eventQueueOverflowNb++;
+        return;
+    }
+    if (index == 255) {  // copy the payload, the next prog telegram may overwrite the com object before dispatch
+        KnxProgEvent progEvent;
+        _progComObj.getValue(progEvent.value);
+        _progEventQueue.push(progEvent);
+    }
+    KnxComObjEvent event;
+    event.index = index;
+    event.command = command;
+    _eventQueue.push(event);
+}
+
+/**
+ * Dispatch the queued com object updates, up to _maxEventsPerTask
+ * @return true if updates are left
+ */
+bool KnxDevice::dispatchComObjEvents(void) {
+    KnxComObjEvent event;
+    for (byte nb = 0; !_maxEventsPerTask || (nb < _maxEventsPerTask); nb++) {
+        if (!_eventQueue.pop(event)) return false;
+        if (event.index == 255) {
+            _progEventQueue.pop(_progEvent);
+            _progEventDispatching = true;  // read(255, ...) returns the payload of this telegram
+            dispatchComObjEvent(event.index, event.command);
+            _progEventDispatching = false;
+        } else {
+            dispatchComObjEvent(event.index, event.command);
+        }
+    }
+    return _eventQueue.getItemCount() != 0;
+}
+
+/**
+ * Set the max. nb of com object updates dispatched per task() call
+ * @param maxEvents 0 = all
+ */
+void KnxDevice::setMaxEventsPerTask(byte maxEvents) {
+    _maxEventsPerTask = maxEvents;
+}
+
+/**
+ * Get the nb of com object updates lost because the event queue was full
+ */
+word KnxDevice::getEventQueueOverflowNb(void) const {
+    return _eventQueueOverflowNb;
+}
+
+/**
+ * Get the nb of com object value updates done by the KNX stack (wraps around)
+ */
+word KnxDevice::getValueUpdateNb(void) const {
+#if defined(KNX_RTOS_TASK)
+    return __atomic_load_n(&_valueUpdateNb, __ATOMIC_RELAXED);
+#else
+    return _valueUpdateNb;
+#endif
+}
+
+/**
+ * Get the next com object updated from the bus since it was last returned, and clear its flag
+ * The bitset is scanned one word at a time, so the cost depends on the nb of updates, not of com objects
+ * @return index of the com object, KNX_DEVICE_NO_COMOBJ if none
+ */
+byte KnxDevice::nextDirty(void) {
+    for (byte w = 0; w < KNX_DIRTY_WORDS; w++) {
+#if defined(KNX_RTOS_TASK)
+        uint32_t bits = __atomic_load_n(&_dirty[w], __ATOMIC_ACQUIRE);
+#else
+        uint32_t bits = _dirty[w];
+#endif
+        if (!bits) continue;
+        byte bit = __builtin_ctzl(bits);
+#if defined(KNX_RTOS_TASK)
+        __atomic_fetch_and(&_dirty[w], ~((uint32_t)1 << bit), __ATOMIC_RELAXED);
+#else
+        _dirty[w] &= ~((uint32_t)1 << bit);
+#endif
+        return (w << 5) + bit;
+    }
+    return KNX_DEVICE_NO_COMOBJ;
+}
+
+/**
+ * Call the application callback for a com object update
+ * The handler registered for the com object is called if any (see setComObjectHandler()), otherwise
+ * written values are routed through konnektingKnxEvents() (programming com object), responses go to knxEvents()
+ */
+void KnxDevice::dispatchComObjEvent(byte index, byte command) {
+    if ((command != KNX_COMMAND_VALUE_RESPONSE) && !Konnekting.isActive()) {
+        DEBUG_PRINTLN(F("No event routing, because not active: #%d"), index);
+        return;
+    }
+    if ((index != 255) && Knx._comObjHandlers && Knx._comObjHandlers[index].handler) {
+        Knx._comObjHandlers[index].handler(index, Knx._comObjHandlers[index].ctx);
+    } else if (command == KNX_COMMAND_VALUE_RESPONSE) {
+        knxEvents(index);
+    } else {
+        DEBUG_PRINTLN(F("Routing event to konnektingKnxEvents #%d"), index);
+        konnektingKnxEvents(index);
+    }
+}
+
+/**
+ * Sequence lock of the com object values: the KNX stack makes the sequence nb odd while it updates a value,
+ * a reader retries if the nb was odd or has changed meanwhile. Only needed while the KNX task runs.
+ */
+void KnxDevice::beginValueUpdate(void) {
+#if defined(KNX_RTOS_TASK)
+    __atomic_store_n(&_valueSeq, (word)(_valueSeq + 1), __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+}
+
+void KnxDevice::endValueUpdate(void) {
+#if defined(KNX_RTOS_TASK)
+    __atomic_store_n(&_valueUpdateNb, (word)(_valueUpdateNb + 1), __ATOMIC_RELAXED);
+    __atomic_store_n(&_valueSeq, (word)(_valueSeq + 1), __ATOMIC_RELEASE);
+#else
+    _valueUpdateNb++;
+#endif
+}
+
+word KnxDevice::beginValueRead(void) const {
+#if defined(KNX_RTOS_TASK)
+    word seq;
+    while ((seq = __atomic_load_n(&_valueSeq, __ATOMIC_ACQUIRE)) & 1)
+        ;  // update ongoing
+    return seq;
+#else
+    return 0;
+#endif
+}
+
+bool KnxDevice::endValueRead(word seq) const {
+#if defined(KNX_RTOS_TASK)
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&_valueSeq, __ATOMIC_RELAXED) == seq;
+#else
+    (void)seq;
+    return true;
+#endif
+}
+
+#if defined(KNX_RTOS_TASK)
+/**
+ * Run the KNX stack in a dedicated task
+ * @param core core the task is pinned to (ESP32)
+ * @param priority task priority
+ * @return false if the device is not started, the task runs already or could not be created
+ */
+bool KnxDevice::startRtosTask(byte core, byte priority) {
+    if (_rtosRunning || !_tpuart) return false;
+    _rtosStop = false;
+    _rtosRunning = true;  // set before the task starts, so the task sees it
+    if (!knxRtosStartTask(_rtosTask, &KnxDevice::rtosTaskLoop, this, core, priority, KNX_RTOS_TASK_STACK_SIZE)) {
+        DEBUG_PRINTLN(F("KNX task could not be created"));
+        _rtosRunning = false;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Stop the KNX task and wait for its end
+ */
+void KnxDevice::stopRtosTask(void) {
+    if (!_rtosRunning) return;
+    _rtosStop = true;
+    knxRtosSignal(_rtosTask);
+    knxRtosJoinTask(_rtosTask, _rtosRunning);
+    _rtosRunning = false;
+    // TX actions the task has not taken over yet
+    takeOverRtosTxActions();
+}
+
+/**
+ * Queue the TX actions handed over by the application through the ring
+ * The application has got their id already (write() returned KNX_DEVICE_OK), so a dropped one is notified
+ */
+void KnxDevice::takeOverRtosTxActions(void) {
+    TxAction action;
+    while (_rtosTxRing.pop(action)) {
+        if (insertTxAction(action) != KNX_DEVICE_OK) {
+            notifyTxCompletion(action.id, action.index, KNX_TX_DROPPED, micros() - action.queuedTimeMicros, 0);
+        }
+    }
+}
+
+/**
+ * Returns true while the KNX task runs
+ */
+bool KnxDevice::isRtosTaskRunning(void) const {
+    return _rtosRunning;
+}
+
+/**
+ * Get the nb of TX completions lost because task() has not been called in time
+ */
+word KnxDevice::getRtosCompletionOverflowNb(void) const {
+    return _rtosCompletionOverflowNb;
+}
+
+/**
+ * Dispatch the TX completions passed by the KNX task
+ * They are left in the ring for getTxCompletion() if no callback is set
+ */
+void KnxDevice::dispatchTxCompletions(void) {
+    if (_txCompletionCallback) {
+        KnxTxCompletion completion;
+        while (_rtosCompletionRing.pop(completion)) _txCompletionCallback(completion);
+    }
+}
+
+/**
+ * Static function of the KNX task: run the KNX stack, then sleep until the next deadline
+ * or until signaled (TX action requested, bytes collected by rxIsr())
+ */
+void KnxDevice::rtosTaskLoop(void* device) {
+    KnxDevice* knx = (KnxDevice*)device;
+    while (!knx->_rtosStop) {
+        unsigned long delay = knx->serviceTask(KNX_RTOS_TASK_BUDGET);
+        knxRtosWait(knx->_rtosTask, min(delay, (unsigned long)KNX_RTOS_TASK_MAX_WAIT));
+    }
+    knx->_rtosRunning = false;
+    knxRtosExitTask();
+}
+#endif
+
+/**
+ * Update the adaptive ACK timeout with the confirm latency of a sent telegram
+ * Same estimation as for TCP retransmission timeouts: smoothed latency + 4 times its mean deviation
+ */
+void KnxDevice::updateAckTimeout(unsigned long confirmLatency) {
+    if (!_txRetryPolicy.adaptiveAckTimeout) return;
+
+    if (!_txConfirmLatencyAvg) {
+        _txConfirmLatencyAvg = confirmLatency;
+        _txConfirmLatencyDev = confirmLatency / 2;
+    } else {
+        long error = (long)confirmLatency - (long)_txConfirmLatencyAvg;
+        _txConfirmLatencyAvg += error / 8;
+        _txConfirmLatencyDev += ((error < 0 ? -error : error) - (long)_txConfirmLatencyDev) / 4;
+    }
+    unsigned long timeout = (_txConfirmLatencyAvg + 4 * _txConfirmLatencyDev) / 1000;
+    if (timeout < KNX_TX_ACK_TIMEOUT_MIN) timeout = KNX_TX_ACK_TIMEOUT_MIN;
+    if (timeout > KNX_TX_ACK_TIMEOUT) timeout = KNX_TX_ACK_TIMEOUT;
+    _txAckTimeout = timeout;
+    _tpuart->setAckTimeout(_txAckTimeout);
 }
 
 template <typename T>
@@ -490,32 +1735,20 @@ KnxDeviceStatus ConvertFromDpt(const byte dptOriginValue[], T& resultValue, byte
     switch (dptFormat) {
         case KNX_DPT_FORMAT_U16:
         case KNX_DPT_FORMAT_V16:
-            resultValue = (T)((unsigned int)dptOriginValue[0] << 8);
-            resultValue += (T)(dptOriginValue[1]);
+            KnxDptCodec<KNX_DPT_FORMAT_U16>::decode(dptOriginValue, resultValue);
             return KNX_DEVICE_OK;
             break;
 
         case KNX_DPT_FORMAT_U32:
         case KNX_DPT_FORMAT_V32:
-            resultValue = (T)((unsigned long)dptOriginValue[0] << 24);
-            resultValue += (T)((unsigned long)dptOriginValue[1] << 16);
-            resultValue += (T)((unsigned long)dptOriginValue[2] << 8);
-            resultValue += (T)(dptOriginValue[3]);
+            KnxDptCodec<KNX_DPT_FORMAT_U32>::decode(dptOriginValue, resultValue);
             return KNX_DEVICE_OK;
             break;
 
-        case KNX_DPT_FORMAT_F16: {
-            // Get the DPT sign, mantissa and exponent
-            int signMultiplier = (dptOriginValue[0] & 0x80) ? -1 : 1;
-            word absoluteMantissa = dptOriginValue[1] + ((dptOriginValue[0] & 0x07) << 8);
-            if (signMultiplier == -1) {  // Calculate absolute mantissa value in case of negative mantissa
-                // Abs = 2's complement + 1
-                absoluteMantissa = ((~absoluteMantissa) & 0x07FF) + 1;
-            }
-            byte exponent = (dptOriginValue[0] & 0x78) >> 3;
-            resultValue = (T)(0.01 * ((long)absoluteMantissa << exponent) * signMultiplier);
+        case KNX_DPT_FORMAT_F16:
+            KnxDptCodec<KNX_DPT_FORMAT_F16>::decode(dptOriginValue, resultValue);
             return KNX_DEVICE_OK;
-        } break;
+            break;
 
         case KNX_DPT_FORMAT_F32:
             return KNX_DEVICE_NOT_IMPLEMENTED;
@@ -540,47 +1773,20 @@ KnxDeviceStatus ConvertToDpt(T originValue, byte dptDestValue[], byte dptFormat)
     switch (dptFormat) {
         case KNX_DPT_FORMAT_U16:
         case KNX_DPT_FORMAT_V16:
-            dptDestValue[0] = (byte)((unsigned int)originValue >> 8);
-            dptDestValue[1] = (byte)(originValue);
+            KnxDptCodec<KNX_DPT_FORMAT_U16>::encode(originValue, dptDestValue);
             return KNX_DEVICE_OK;
             break;
 
         case KNX_DPT_FORMAT_U32:
         case KNX_DPT_FORMAT_V32:
-            dptDestValue[0] = (byte)((unsigned long)originValue >> 24);
-            dptDestValue[1] = (byte)((unsigned long)originValue >> 16);
-            dptDestValue[2] = (byte)((unsigned long)originValue >> 8);
-            dptDestValue[3] = (byte)(originValue);
+            KnxDptCodec<KNX_DPT_FORMAT_U32>::encode(originValue, dptDestValue);
             return KNX_DEVICE_OK;
             break;
 
-        case KNX_DPT_FORMAT_F16: {
-            long longValuex100 = (long)(100.0 * originValue);
-            bool negativeSign = (longValuex100 & 0x80000000) ? true : false;
-            byte exponent = 0;
-            byte round = 0;
-
-            if (negativeSign) {
-                while (longValuex100 < (long)(-2048)) {
-                    exponent++;
-                    round = (byte)(longValuex100)&1;
-                    longValuex100 >>= 1;
-                    longValuex100 |= 0x80000000;
-                }
-            } else {
-                while (longValuex100 > (long)(2047)) {
-                    exponent++;
-                    round = (byte)(longValuex100)&1;
-                    longValuex100 >>= 1;
-                }
-            }
-            if (round) longValuex100++;
-            dptDestValue[1] = (byte)longValuex100;
-            dptDestValue[0] = (byte)(longValuex100 >> 8) & 0x7;
-            dptDestValue[0] += exponent << 3;
-            if (negativeSign) dptDestValue[0] += 0x80;
+        case KNX_DPT_FORMAT_F16:
+            KnxDptCodec<KNX_DPT_FORMAT_F16>::encode(originValue, dptDestValue);
             return KNX_DEVICE_OK;
-        } break;
+            break;
 
         case KNX_DPT_FORMAT_F32:
             return KNX_DEVICE_NOT_IMPLEMENTED;
@@ -21,9 +21,14 @@
 #include "Arduino.h"
 #include "KnxTelegram.h"
 #include "KnxComObject.h"
+#include "KnxDptCodec.h"
 #include "RingBuff.h"
+#include "PrioQueue.h"
+#include "KnxTimerWheel.h"
 #include "KnxTpUart.h"
+#include "KnxRtos.h"
 #include "KonnektingDevice.h"
+#include "LockFreeRingBuff.h"
 
 // !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
 // DEBUG :
@@ -35,6 +40,8 @@ enum KnxDeviceStatus {
   KNX_DEVICE_INVALID_INDEX = 1,
   KNX_DEVICE_INIT_ERROR = 2,
   KNX_DEVICE_COMOBJ_INACTIVE = 3,
+  KNX_DEVICE_TX_QUEUE_FULL = 4,
+  KNX_DEVICE_FILTERED = 5,  // write() discarded by the send-on-change filter, nothing queued
   KNX_DEVICE_NOT_IMPLEMENTED = 254,
   KNX_DEVICE_ERROR = 255
 };
@@ -48,6 +55,160 @@ inline word G_ADDR(byte maingrp, byte midgrp, byte subgrp)
 
 #define ACTIONS_QUEUE_SIZE 16
 
+// TX action priority levels, in the order they are served (see KnxComObject::setPriority())
+#define TX_PRIORITY_LEVEL_SYSTEM 0
+#define TX_PRIORITY_LEVEL_ALARM  1
+#define TX_PRIORITY_LEVEL_HIGH   2
+#define TX_PRIORITY_LEVEL_NORMAL 3
+#define TX_PRIORITY_LEVELS       4
+
+// Nb of times waiting TX actions may be passed over by more urgent ones before they are served anyway
+#define TX_PRIORITY_AGING_LIMIT 8
+
+// Lower limit (ms) of the adaptive ACK timeout, the upper limit is KNX_TX_ACK_TIMEOUT
+#define KNX_TX_ACK_TIMEOUT_MIN 100
+
+// Retry policy for telegrams not confirmed by the TPUART (NACK, no answer or TPUART reset)
+typedef struct KnxTxRetryPolicy {
+  byte maxAttempts;         // Max. nb of transmissions of a telegram, 1 = no retry
+  word backoffMillis;       // Delay before the 1st retry, doubled for each further retry, plus up to 50% random jitter
+  word maxBackoffMillis;    // Upper limit of the delay (without jitter)
+  bool adaptiveAckTimeout;  // Derive the ACK timeout from the measured confirm latency instead of KNX_TX_ACK_TIMEOUT
+} KnxTxRetryPolicy;
+
+// Value returned by task(budgetMicros) when nothing is scheduled, i.e. only UART activity needs it to run
+#define KNX_TASK_NO_DEADLINE KNX_TPUART_NO_DEADLINE
+
+// Init reads of the com objects with Init attribute (after begin()): several reads are pipelined,
+// each one is sent once the bus has been idle for KNX_INIT_READ_GAP
+#define KNX_INIT_READ_WINDOW 4          // Max. nb of init reads waiting for their response
+#define KNX_INIT_READ_GAP 20            // Min. bus idle time (ms) before an init read, and between two init reads
+#define KNX_INIT_READ_TIMEOUT 1000      // Time (ms) an init read waits for its response
+#define KNX_INIT_READ_ROUND_DELAY 2000  // Min. time (ms) before the com objects without response are read again
+
+// Resolution (ms) of the cyclic transmissions, see setCyclicSend()
+#define KNX_CYCLIC_TICK_MILLIS 100
+
+// Size of the queue of com object updates waiting to be dispatched by task() (power of two, max. 128)
+#if defined(KONNEKTING_SYSTEM_TYPE_DEFAULT)
+#define KNX_EVENT_QUEUE_SIZE 32
+#else
+#define KNX_EVENT_QUEUE_SIZE 16
+#endif
+
+// Nb of prog com obj telegrams that can wait in the event queue, each one with a copy of its payload (power of two)
+#if defined(KONNEKTING_SYSTEM_TYPE_DEFAULT)
+#define KNX_PROG_EVENT_QUEUE_SIZE 8
+#else
+#define KNX_PROG_EVENT_QUEUE_SIZE 4
+#endif
+
+// Nb of 32 bit words of the bitset flagging the com objects updated from the bus (see nextDirty())
+#define KNX_DIRTY_WORDS ((KONNEKTING_NUMBER_OF_COMOBJECTS + 31) / 32)
+
+// Returned by nextDirty() when no com object is left
+#define KNX_DEVICE_NO_COMOBJ 255
+
+// Size of the ring keeping the TX completions until they are polled (see getTxCompletion())
+#define KNX_TX_COMPLETION_RING_SIZE 8
+
+#if defined(KNX_RTOS_TASK)
+// Sizes of the lock-free rings between the application and the KNX task (power of two, max. 128)
+#define KNX_RTOS_TX_RING_SIZE 16      // TX actions requested by the application
+
+// Max. time (usec) spent in one run of the KNX task before it yields
+#define KNX_RTOS_TASK_BUDGET 2000
+
+// Max. time (usec) the KNX task sleeps without being signaled
+#define KNX_RTOS_TASK_MAX_WAIT 100000
+#endif
+
+// Id of a TX action requested by the application, 0 = no id
+typedef word KnxTxActionId;
+
+// Outcome of a TX action, the first values match TpUartTxAck
+enum KnxTxOutcome {
+  KNX_TX_ACKED = 0,         // telegram confirmed with ACK
+  KNX_TX_NACKED,            // telegram confirmed with NACK (after the last allowed attempt)
+  KNX_TX_NO_ANSWER,         // telegram not confirmed within the ACK timeout (after the last allowed attempt)
+  KNX_TX_TPUART_RESET,      // TPUART reset or not available during the transmission
+  KNX_TX_DROPPED,           // action dropped because the TX queue was full
+  KNX_TX_COALESCED,         // write replaced by a newer write on the same com object, see setWriteCoalescing()
+  KNX_TX_LOCAL_ONLY,        // write performed without telegram (com object without transmit attribute)
+  KNX_TX_EXPIRED            // action older than its max. age when its turn came, see write()
+};
+
+// Completion of a TX action requested by the application
+typedef struct KnxTxCompletion {
+  KnxTxActionId id;         // id of the action (see getLastTxActionId())
+  byte index;               // index of the involved ComObject
+  KnxTxOutcome outcome;
+  unsigned long queueLatency; // time (usec) spent in the TX queue
+  unsigned long busLatency;   // time (usec) from the start of the transmission to the TPUART confirm, retries included
+} KnxTxCompletion;
+
+// Kind of the last value passed by a send-on-change filter
+enum KnxChangeValueKind {
+  KNX_CHANGE_NONE = 0,          // no value passed yet
+  KNX_CHANGE_REAL,              // floating point value
+  KNX_CHANGE_INTEGER,           // integral value
+  KNX_CHANGE_RAW                // raw DPT value
+};
+
+// Send-on-change filter of a com object, see setChangeFilter()
+typedef struct KnxChangeFilter {
+  float absThreshold;           // min. absolute change, 0 = not used
+  float relThreshold;           // min. relative change (0.1 = 10%), 0 = not used
+  word minIntervalMillis;       // min. time between two sent values
+  bool active;
+  byte lastKind;                // KnxChangeValueKind of the last value passed
+  union {                       // last value passed
+    double real;
+    unsigned long integer;      // compared in the type of the written value
+  } lastValue;
+  byte *lastRaw;                // last raw DPT value passed (allocated by the first raw value passed)
+  unsigned long lastSendMillis; // time the last value passed
+} KnxChangeFilter;
+
+// True for the integral types, whose values are compared by the send-on-change filters in their own type
+template <typename T> struct KnxIsIntegral { enum { value = true }; };
+template <> struct KnxIsIntegral<float> { enum { value = false }; };
+template <> struct KnxIsIntegral<double> { enum { value = false }; };
+
+// Decoded value cache of a long com object, see setReadCache()
+typedef struct KnxReadCache {
+  union {
+    unsigned long integer;      // value of U16, V16, U32 and V32 formats
+    double real;                // value of F16 format
+  };
+  byte format;                  // DPT format of the com object
+  bool active;
+} KnxReadCache;
+
+// Handler of the updates of one com object, see setComObjectHandler()
+typedef void (*KnxComObjectHandler)(byte index, void* ctx);
+
+// Entry of the com object handler table
+typedef struct KnxComObjectHandlerEntry {
+  KnxComObjectHandler handler;
+  void* ctx;                // passed to the handler as is
+} KnxComObjectHandlerEntry;
+
+// Com object update, queued by the KNX stack until task() dispatches it to the application
+typedef struct KnxComObjEvent {
+  byte index;               // index of the updated ComObject
+  byte command;             // KNX_COMMAND_VALUE_RESPONSE or KNX_COMMAND_VALUE_WRITE
+} KnxComObjEvent;
+
+// Payload of a prog com obj update, copied as the next telegram overwrites the com object before task() dispatches it
+typedef struct KnxProgEvent {
+  byte value[14];           // KNX_DPT_60000_60000 value
+} KnxProgEvent;
+
+// Tag selecting the encoding of a DPT value in write<dpt>() at compile time: in the TX action (short)
+// or in allocated memory (long). Overloads on it keep the other encoding uninstantiated (no "if constexpr" in C++11)
+template <bool isLong> struct KnxDptLengthTag {};
+
 // KnxDevice internal state
 enum InternalDeviceState {
   INIT,
@@ -59,12 +220,16 @@ enum InternalDeviceState {
 enum TxActionType {
   KNX_READ_REQUEST,
   KNX_WRITE_REQUEST,
-  KNX_RESPONSE_REQUEST
+  KNX_RESPONSE_REQUEST,
+  KNX_CYCLIC_WRITE_REQUEST  // send the current value of the com object (cyclic transmission)
 };
 
 typedef struct TxAction{
   TxActionType command; // Action type to be performed
   byte index; // Index of the involved ComObject
+  KnxTxActionId id; // Id of the action, 0 for internal actions (init reads, read responses)
+  unsigned long queuedTimeMicros; // Time the action has been queued
+  unsigned long expiryTimeMillis; // Time the action expires if not performed yet, 0 = never
   union { // Value
     // Field used in case of short value (value width <= 1 byte)
     struct {
@@ -109,8 +274,86 @@ class KnxDevice {
     // TPUART associated to the KNX Device
     KnxTpUart *_tpuart;                             
     
-    // Queue of transmit actions to be performed
-    RingBuff<TxAction, ACTIONS_QUEUE_SIZE> _txActionList; 
+    // Queue of transmit actions to be performed, most urgent first
+    PrioQueue<TxAction, ACTIONS_QUEUE_SIZE, TX_PRIORITY_LEVELS> _txActionList; 
+    
+    // Retry policy for not confirmed telegrams
+    KnxTxRetryPolicy _txRetryPolicy;
+    
+    // Nb of transmissions of the current telegram
+    byte _txAttempts;
+    
+    // True if the current telegram waits for its retry
+    bool _txRetryPending;
+    
+    // Time (in msec) the retry of the current telegram is due
+    unsigned long _txRetryTimeMillis;
+    
+    // Current ACK timeout (in msec)
+    word _txAckTimeout;
+    
+    // Smoothed confirm latency and its mean deviation (in usec), for the adaptive ACK timeout
+    unsigned long _txConfirmLatencyAvg;
+    unsigned long _txConfirmLatencyDev;
+    
+    // Nb of sent telegrams per TPUART confirm value (TpUartTxAck)
+    word _txAckNb[TPUART_RESET_RESPONSE + 1];
+    
+    // Nb of retries, and nb of telegrams given up after the last retry
+    word _txRetriesNb;
+    word _txFailedNb;
+    
+    // Id of the last TX action requested by the application
+    KnxTxActionId _lastTxActionId;
+    
+    // Id, com object index and times (in usec) of the action being transmitted
+    KnxTxActionId _txActionId;
+    byte _txActionIndex;
+    unsigned long _txActionQueueLatency;
+    unsigned long _txActionStartMicros;
+    
+    // Function called on TX action completion, NULL = completions kept in _txCompletions
+    void (*_txCompletionCallback)(const KnxTxCompletion&);
+    
+    // TX completions waiting to be polled, the oldest are overwritten
+    RingBuff<KnxTxCompletion, KNX_TX_COMPLETION_RING_SIZE> _txCompletions;
+    
+    // Nb of TX actions discarded because they expired in the queue
+    word _txExpiredActionsNb;
+    
+    // Timers of the cyclic transmissions, one per com object (allocated by the first setCyclicSend() call)
+    KnxTimerWheel _cyclicWheel;
+    
+    // Time (in msec) of the last cyclic transmissions timer tick
+    unsigned long _cyclicTickTimeMillis;
+    
+    // Send-on-change filters, one per com object (allocated by the first setChangeFilter() call)
+    KnxChangeFilter *_changeFilters;
+    
+    // Nb of writes discarded by the send-on-change filters
+    word _filteredWritesNb;
+    
+    // Decoded value caches, one per com object (allocated by the first setReadCache() call)
+    KnxReadCache *_readCaches;
+    
+    // Update handlers, one per com object (allocated by the first setComObjectHandler() call)
+    KnxComObjectHandlerEntry *_comObjHandlers;
+    
+    // True if a new TX action replaces the least urgent queued one when the queue is full,
+    // false if the new action is rejected (KNX_DEVICE_TX_QUEUE_FULL)
+    bool _txQueueOverwrite;
+    
+    // Max. nb of TX actions queued at the same time
+    byte _txQueueHighWatermark;
+    
+    // Nb of TX actions dropped because the queue was full
+    word _txDroppedActionsNb;
+    
+    // True if a write on a com object replaces the value of a write on the same com object still queued
+    bool _writeCoalescing;
+    
+    // Nb of writes merged into a write still queued
+    word _coalescedWritesNb;
     
     // True when all the Com Object with Init attr have been initialized
     bool _initCompleted;                         
@@ -119,19 +362,77 @@ class KnxDevice {
     byte _initIndex;                                
     
     // Time (in msec) of the last init (read) request on the bus
-    word _lastInitTimeMillis;                       
+    unsigned long _lastInitTimeMillis;
+    
+    // Com objects whose init read waits for its response (0xFF = free), and the times the reads have been queued
+    byte _initReadIndex[KNX_INIT_READ_WINDOW];
+    unsigned long _initReadTimeMillis[KNX_INIT_READ_WINDOW];
     
-    // Time (in msec) of the last Tpuart Rx activity;
-    word _lastRXTimeMicros;                         
+    // Nb of bus telegrams seen by the TPUART at the last check, and time (in msec) the last one has been seen
+    word _busTelegramsNb;
+    unsigned long _lastBusTelegramMillis;
     
-    // Time (in msec) of the last Tpuart Tx activity;
-    word _lastTXTimeMicros;                         
+    // Time (in usec) of the last Tpuart Rx activity;
+    unsigned long _lastRXTimeMicros;
+    
+    // Time (in usec) of the last Tpuart Tx activity;
+    unsigned long _lastTXTimeMicros;
     
     // Telegram object used for telegrams sending
     KnxTelegram _txTelegram;                        
     
-    // Reference to the telegram received by the TPUART
-    KnxTelegram *_rxTelegram;                       
+    // True if the TPUART RX bytes are collected by rxIsr() (called by the application)
+    bool _rxIsrMode;
+    
+    // Max. nb of TPUART RX bytes handled per RX task execution
+    byte _rxByteBudget;
+    
+    // True if the telegrams are handed over to the TPUART in one write
+    bool _txBurstMode;
+    
+    // Function called by rxIsr() when bytes have been received
+    void (*_rxWakeCallback)(void);
+
+    // Nb of com object value updates done by the KNX stack (wraps around), see getValueUpdateNb()
+    word _valueUpdateNb;
+
+#if defined(KNX_RTOS_TASK)
+    // Sequence nb of the com object values, odd while a value is being updated (see beginValueUpdate())
+    word _valueSeq;
+    
+    // KNX task, see startRtosTask()
+    KnxRtosTaskHandle _rtosTask;
+    
+    // True while the KNX task runs, and true to ask it to stop
+    volatile bool _rtosRunning;
+    volatile bool _rtosStop;
+    
+    // TX actions requested by the application, inserted into _txActionList by the KNX task
+    LockFreeRingBuff<TxAction, KNX_RTOS_TX_RING_SIZE> _rtosTxRing;
+    
+    // TX completions, dispatched to the application by task()
+    LockFreeRingBuff<KnxTxCompletion, KNX_TX_COMPLETION_RING_SIZE> _rtosCompletionRing;
+    
+    // Nb of TX completions lost because task() has not been called in time
+    word _rtosCompletionOverflowNb;
+#endif
+    
+    // Com object updates waiting to be dispatched by task()
+    LockFreeRingBuff<KnxComObjEvent, KNX_EVENT_QUEUE_SIZE> _eventQueue;
+
+    // Payloads of the prog com obj updates in _eventQueue, and the one being dispatched (returned by read(255, ...))
+    LockFreeRingBuff<KnxProgEvent, KNX_PROG_EVENT_QUEUE_SIZE> _progEventQueue;
+    KnxProgEvent _progEvent;
+    boolean _progEventDispatching;
+    
+    // Max. nb of com object updates dispatched per task() call, 0 = all
+    byte _maxEventsPerTask;
+    
+    // Nb of com object updates lost because the event queue was full
+    word _eventQueueOverflowNb;
+    
+    // One bit per com object updated from the bus and not returned by nextDirty() yet
+    uint32_t _dirty[KNX_DIRTY_WORDS];
     
     // Constructor, Destructor
     // private constructor (singleton design pattern)
@@ -164,9 +465,89 @@ class KnxDevice {
     /*
      * KNX device execution task
      * This function shall be called in the "loop()" Arduino function
+     * task() stays as long as the TPUART is active (telegram reception or transmission ongoing),
+     * which may block loop() for tens of ms.
+     * The com object updates received are dispatched (knxEvents() or handlers) at the end of task().
+     * Then the warm start snapshot is written if due (see KonnektingDevice::enableWarmStart()).
      */
     void task(void);
 
+    /*
+     * KNX device execution task with a time budget, to be called instead of task()
+     * task(budgetMicros) returns once budgetMicros have elapsed (0 = no limit), and the remaining
+     * work is done by the next calls. In that case it shall be called at least every 0,5ms during receptions
+     * (or use setRxIsrMode()), so that received telegrams are acknowledged in time.
+     * Returns the time (in usec) until task() needs to run again (next RX/TX slot, ACK timeout, retry, init read,
+     * cyclic transmission), or KNX_TASK_NO_DEADLINE if only UART activity needs it. Until then, the application
+     * may idle or sleep, provided UART activity wakes it up (see setRxWakeCallback() in RX ISR mode).
+     * 0 is returned while received com object updates are left to dispatch (see setMaxEventsPerTask()).
+     * The warm start snapshot is not written within the budget, the application calls
+     * Konnekting.warmStartTask() instead, at a time a memory write (and commit) is acceptable.
+     */
+    unsigned long task(unsigned long budgetMicros);
+
+#if defined(KNX_RTOS_TASK)
+    /**
+     * Run the KNX stack (RX/TX state machines, TX queue, init reads, cyclic transmissions) in a dedicated task,
+     * pinned to a core, so that its timing does not depend on loop() and WiFi activity
+     * task() shall still be called in loop(): it only dispatches the com object updates (knxEvents())
+     * and the TX completions to the application, and returns KNX_TASK_NO_DEADLINE (or 0 if updates are left).
+     * write() and update() hand the TX actions over to the KNX task through a lock-free ring,
+     * KNX_DEVICE_TX_QUEUE_FULL is returned if the ring is full. If the TX queue turns out to be full when the
+     * KNX task takes an action over, the action is notified as KNX_TX_DROPPED (see setTxCompletionCallback()).
+     * NB : has to be called after the device has been configured (i.e. after Konnekting.init() and the
+     * set...() functions), the configuration must not be changed while the KNX task runs
+     * @return false if the device is not started or the task could not be created
+     */
+    bool startRtosTask(byte core = KNX_RTOS_TASK_CORE, byte priority = KNX_RTOS_TASK_PRIORITY);
+
+    /**
+     * Stop the KNX task and wait for its end, task() runs the KNX stack again afterwards
+     * Also done by end()
+     */
+    void stopRtosTask(void);
+
+    /**
+     * Returns true while the KNX task runs
+     */
+    bool isRtosTaskRunning(void) const;
+
+    /**
+     * Get the nb of TX completions lost because task() has not been called often enough while the KNX task runs
+     */
+    word getRtosCompletionOverflowNb(void) const;
+#endif
+
+    /**
+     * Set the max. nb of com object updates dispatched (knxEvents() or handler calls) per task() call
+     * The updates are recorded by the RX path and dispatched by task() once RX/TX servicing is done,
+     * so slow handlers (EEPROM write, sensor read) do not delay the TPUART. Limiting their nb per call
+     * bounds the time task() spends in application code, task(budgetMicros) returns 0 while updates are left.
+     * @param maxEvents 0 (default) = all the queued updates
+     */
+    void setMaxEventsPerTask(byte maxEvents);
+
+    /**
+     * Get the nb of com object updates lost because the event queue (KNX_EVENT_QUEUE_SIZE) was full,
+     * i.e. task() has not dispatched them in time (the com object value is updated anyway)
+     */
+    word getEventQueueOverflowNb(void) const;
+
+    /**
+     * Get the nb of com object value updates done by the KNX stack (bus telegrams, write() actions), wraps around
+     * Compared with a previous value, it tells whether any com object value may have changed since then
+     */
+    word getValueUpdateNb(void) const;
+
+    /**
+     * Get the next com object updated from the bus (write or response) since it was last returned, and clear its flag
+     * Lets the application poll the changes instead of reading every com object on each loop, e.g.
+     * while ((index = Knx.nextDirty()) != KNX_DEVICE_NO_COMOBJ) { ... }
+     * The flags are set whether the updates are dispatched (knxEvents(), handlers) or not.
+     * @return index of the com object, KNX_DEVICE_NO_COMOBJ if none has been updated
+     */
+    byte nextDirty(void);
+
     /* 
      * Quick method to read a short (<=1 byte) com object
      * NB : The returned value will be hazardous in case of use with long objects
@@ -179,6 +560,14 @@ class KnxDevice {
      */
     template <typename T>  KnxDeviceStatus read(byte objectIndex, T& returnedValue);
 
+    /*
+     *  Read a com object with a DPT known at compile time, e.g. Knx.read<KNX_DPT_9_001>(index, temperature)
+     * The length and the DPT codec are resolved at compile time, the use of an unsupported DPT format does not compile
+     * KNX_DEVICE_INVALID_INDEX is returned if the com object does not exist,
+     * KNX_DEVICE_ERROR if the com object has not the length of the DPT
+     */
+    template <KnxDpt dpt, typename T>  KnxDeviceStatus read(byte objectIndex, T& returnedValue);
+
     /*
      *  Read any type of com object (DPT value provided as is)
      */
@@ -187,27 +576,228 @@ class KnxDevice {
     // Update com object functions :
     // For all the update functions, the com object value is updated locally
     // and a telegram is sent on the KNX bus if the object has both COMMUNICATION & TRANSMIT attributes set
+    // KNX_DEVICE_TX_QUEUE_FULL is returned if the TX queue is full and overwriting is disabled (see setTxQueueOverwrite())
+    // KNX_DEVICE_FILTERED is returned if the value is discarded by the send-on-change filter (see setChangeFilter())
+    // maxAgeMillis (0 = no limit): if the telegram has not been sent within this time (f.i. bus outage),
+    // the value is still updated locally but not sent anymore, so the bus is not flooded with obsolete values
+    // after recovery (see getTxExpiredActionsNb())
 
     /*
      * Update an usual format com object
      * Supported DPT types are short com object, U16, V16, U32, V32, F16 and F32
      */
-    template <typename T>  KnxDeviceStatus write(byte objectIndex, T value);
+    template <typename T>  KnxDeviceStatus write(byte objectIndex, T value, unsigned long maxAgeMillis = 0);
+
+    /*
+     * Update a com object with a DPT known at compile time, e.g. Knx.write<KNX_DPT_9_001>(index, temperature)
+     * The length and the DPT codec are resolved at compile time, the use of an unsupported DPT format does not compile
+     * KNX_DEVICE_INVALID_INDEX is returned if the com object does not exist,
+     * KNX_DEVICE_ERROR if the com object has not the length of the DPT or if out of memory
+     */
+    template <KnxDpt dpt, typename T>  KnxDeviceStatus write(byte objectIndex, T value, unsigned long maxAgeMillis = 0);
 
     /*
      * Update any type of com object (rough DPT value shall be provided)
      */
-    KnxDeviceStatus write(byte objectIndex, byte valuePtr[]);
+    KnxDeviceStatus write(byte objectIndex, byte valuePtr[], unsigned long maxAgeMillis = 0);
     
 
     /*
      * Com Object KNX Bus Update request
      * Request the local object to be updated with the value from the bus
      * NB : the function is asynchroneous, the update completion is notified by the knxEvents() callback
+     * returns KNX_DEVICE_TX_QUEUE_FULL if the TX queue is full and overwriting is disabled
      */
-    void update(byte objectIndex);
+    KnxDeviceStatus update(byte objectIndex);
 
     
+    /**
+     * Select how the bytes received from the TPUART are collected
+     * false (default): collected by task() itself, task() has to be called at least every 0,5ms
+     * true: collected by rxIsr(), which has to be called by the application from a timer ISR or
+     *       UART receive callback. Each byte gets its reception time, so End Of Packets are
+     *       detected correctly even if loop() is slow.
+     * NB : has to be called prior to begin() (i.e. prior to Konnekting.init())
+     */
+    void setRxIsrMode(bool isrMode);
+
+    /**
+     * Set the max. nb of received bytes handled by one TPUART RX task execution (default KNX_RX_BYTE_BUDGET)
+     * All the bytes available are handled at once, up to this budget. 1 handles one byte per execution.
+     * NB : has to be called prior to begin() (i.e. prior to Konnekting.init())
+     */
+    void setRxByteBudget(byte budget);
+
+    /**
+     * Select how the telegrams are handed over to the TPUART
+     * false (default): one byte every 0,8ms
+     * true: the whole telegram at once, for transceivers buffering a complete frame (TP-UART2, NCN5120, ...)
+     * NB : has to be called prior to begin() (i.e. prior to Konnekting.init())
+     */
+    void setTxBurstMode(bool burstMode);
+
+    /**
+     * Get the time (in usec) needed to hand the last sent telegram over to the TPUART
+     */
+    unsigned long getTxHandOverTime(void) const;
+
+    /**
+     * Collect the bytes received from the TPUART (RX ISR mode only)
+     * To be called from a timer ISR (period < 0,5ms) or UART receive callback
+     */
+    void rxIsr(void);
+
+    /**
+     * Set the function called by rxIsr() when bytes have been received, f.i. to wake up the task calling
+     * task() from an idle/sleep period. Called in ISR context!
+     */
+    void setRxWakeCallback(void (*callback)(void));
+
+    /**
+     * Set a send-on-change filter on a com object: write() calls which don't change the value enough
+     * are discarded before the value is converted and queued (the com object keeps the last value passed)
+     * Numeric values pass if they differ from the last passed value by at least one of the thresholds set,
+     * or if they differ at all when no threshold is set. Integral values are compared in their own type.
+     * Raw DPT values (write(index, byte[])) pass if they differ from the last raw value passed.
+     * In addition, a value passes only if minIntervalMillis have elapsed since the last passed value.
+     * The first value always passes. A value counts as passed only once it has been queued, so a value
+     * rejected by a full TX queue does not hold back the next one.
+     * A discarded write() returns KNX_DEVICE_FILTERED: no TX action is queued, so there is no completion,
+     * and getLastTxActionId() still returns the id of the last queued action.
+     * @param index com object index
+     * @param absThreshold min. absolute change, 0 = not used
+     * @param relThreshold min. change relative to the last passed value (0.1 = 10%), 0 = not used
+     * @param minIntervalMillis min. time between two passed values, 0 = not used
+     * returns KNX_DEVICE_INVALID_INDEX if the com object does not exist, KNX_DEVICE_ERROR if out of memory
+     */
+    KnxDeviceStatus setChangeFilter(byte index, float absThreshold, float relThreshold = 0, word minIntervalMillis = 0);
+
+    /**
+     * Remove the send-on-change filter of a com object, every write() is sent again
+     */
+    KnxDeviceStatus clearChangeFilter(byte index);
+
+    /**
+     * Get the nb of writes discarded by the send-on-change filters
+     */
+    word getFilteredWritesNb(void) const;
+
+    /**
+     * Cache the value of a long com object decoded by read(index, value)
+     * The value is decoded again only once the com object has been updated, repeated reads return the cached value,
+     * converted to the requested type in the same way as an uncached read.
+     * @param index com object index
+     * @param active false to remove the cache
+     * returns KNX_DEVICE_INVALID_INDEX if the com object does not exist,
+     * KNX_DEVICE_ERROR if it is not a long com object (length > 2) or if out of memory
+     */
+    KnxDeviceStatus setReadCache(byte index, bool active = true);
+
+    /**
+     * Send the current value of a com object periodically (write telegram)
+     * The first transmission happens at a random time within the period, so com objects registered
+     * at the same time (f.i. in setup()) do not all send at once
+     * A cyclic transmission is skipped if a write on the com object is still queued
+     * @param index com object index
+     * @param periodMillis period, rounded to KNX_CYCLIC_TICK_MILLIS, max. 65535 ticks; 0 stops the transmissions
+     * returns KNX_DEVICE_INVALID_INDEX if the com object does not exist, KNX_DEVICE_ERROR if out of memory
+     */
+    KnxDeviceStatus setCyclicSend(byte index, unsigned long periodMillis);
+
+    /**
+     * Get the period (in msec) of the cyclic transmission of a com object, 0 if not cyclic
+     */
+    unsigned long getCyclicSend(byte index) const;
+
+    /**
+     * Get the nb of TX actions discarded because they were older than their max. age (see write())
+     */
+    word getTxExpiredActionsNb(void) const;
+
+    /**
+     * Get the id given to the TX action queued by the last successful write() or update() call
+     * The completion of the action is notified with this id, see setTxCompletionCallback() and getTxCompletion()
+     * Calls which queue nothing (errors, KNX_DEVICE_FILTERED) leave it unchanged
+     */
+    KnxTxActionId getLastTxActionId(void) const;
+
+    /**
+     * Set the function called (from task()) on completion of each TX action requested by the application
+     * NULL (default): the completions are kept in a ring of KNX_TX_COMPLETION_RING_SIZE entries to be polled
+     * with getTxCompletion(), the oldest ones are overwritten if not polled in time
+     */
+    void setTxCompletionCallback(void (*callback)(const KnxTxCompletion&));
+
+    /**
+     * Get the oldest TX completion not polled yet (no callback set only)
+     * returns false if there's none
+     */
+    bool getTxCompletion(KnxTxCompletion& completion);
+
+    /**
+     * Set the retry policy for telegrams which are not confirmed by the TPUART (NACK, no answer or TPUART reset)
+     * Default: no retry, fixed ACK timeout (KNX_TX_ACK_TIMEOUT)
+     * While a retry is pending, the other TX actions wait
+     */
+    void setTxRetryPolicy(const KnxTxRetryPolicy& policy);
+
+    /**
+     * Get the nb of telegram transmissions ended with the given TPUART confirm value
+     */
+    word getTxAckNb(TpUartTxAck ack) const;
+
+    /**
+     * Get the nb of telegram retries
+     */
+    word getTxRetriesNb(void) const;
+
+    /**
+     * Get the nb of telegrams given up, i.e. still not confirmed after the last allowed attempt
+     */
+    word getTxFailedNb(void) const;
+
+    /**
+     * Get the current ACK timeout (in msec)
+     */
+    word getTxAckTimeout(void) const;
+
+    /**
+     * Select what happens when a TX action (write, update, read response) is requested while the TX queue is full
+     * true (default): the oldest least urgent queued action is dropped
+     * false: the new action is dropped, write() and update() return KNX_DEVICE_TX_QUEUE_FULL
+     * In both cases the drop is counted (see getTxDroppedActionsNb())
+     */
+    void setTxQueueOverwrite(bool overwrite);
+
+    /**
+     * Get the max. nb of TX actions queued at the same time (max. ACTIONS_QUEUE_SIZE)
+     */
+    byte getTxQueueHighWatermark(void) const;
+
+    /**
+     * Get the nb of TX actions dropped because the TX queue was full
+     */
+    word getTxDroppedActionsNb(void) const;
+
+    /**
+     * Select if a write on a com object replaces the value of a write on the same com object still queued
+     * (i.e. not sent yet), so only the newest value is sent. Default: false, every write is sent
+     * The programming com object is never coalesced
+     * Enable it for state values, where only the latest one matters (not for pulses or counters)
+     */
+    void setWriteCoalescing(bool coalescing);
+
+    /**
+     * Get the nb of writes merged into a write still queued
+     */
+    word getCoalescedWritesNb(void) const;
+
+    /**
+     * Get the nb of received telegrams lost because the RX queue was full
+     * (i.e. task() has not been called often enough during a telegram burst)
+     */
+    word getRxQueueOverflowNb(void) const;
+
     /**
      * TODO document me
      * @return 
@@ -215,14 +805,241 @@ class KnxDevice {
     bool isActive(void) const;
         
     KnxDeviceStatus setComObjectIndicator(byte index, byte indicator);
+    
+    /*
+     * Set the priority of a com object: its telegrams are sent with this priority,
+     * and its TX actions are queued in front of the less urgent ones
+     */
+    KnxDeviceStatus setComObjectPriority(byte index, e_KnxPriority priority);
     KnxDeviceStatus setComObjectAddress(byte index, word addr);
+
+    /*
+     * Set the function called when a com object is updated from the bus (write or response),
+     * instead of knxEvents(): the com object is dispatched with a single table lookup, and library
+     * modules can handle their own com objects
+     * handler NULL removes the handler, the updates go to knxEvents() again
+     * returns KNX_DEVICE_INVALID_INDEX if the com object does not exist, KNX_DEVICE_ERROR if out of memory
+     */
+    KnxDeviceStatus setComObjectHandler(byte index, KnxComObjectHandler handler, void* ctx = NULL);
     
     /*
      *  Gets the address of an commobjects
      */
     word getComObjectAddress(byte index);
+
+    /*
+     * Get the indicator (C, R, W, T, U, I attributes) and the length (see KnxComObject::getLength()) of a com object
+     */
+    byte getComObjectIndicator(byte index);
+    byte getComObjectLength(byte index);
+
+    /*
+     * Returns true if the com object value is valid, i.e. the com object has no Init attribute
+     * or its value has been initialized
+     */
+    bool isComObjectValid(byte index);
+
+    /*
+     * Read the value and the validity of a com object at once, consistent even while
+     * the KNX task updates it (see startRtosTask())
+     */
+    KnxDeviceStatus readComObjectState(byte index, byte value[], bool& valid);
+
+    /*
+     * Set the value of a com object locally, without telegram, and mark it as initialized, so no init read
+     * is sent for it (warm start, see KonnektingDevice::enableWarmStart())
+     * NB : has to be called prior to begin()
+     */
+    KnxDeviceStatus restoreComObjectValue(byte index, const byte value[]);
     
   private:
+    /*
+     * Run the KNX stack, see task()
+     */
+    unsigned long serviceTask(unsigned long budgetMicros);
+
+    /*
+     * Queue the next init read if the window and the bus load allow it
+     */
+    void initReadTask(void);
+
+    /*
+     * Time (in msec) until initReadTask() may queue the next init read
+     */
+    unsigned long getInitReadDelay(void) const;
+
+    /*
+     * Queue a TX action according to the priority of its com object
+     * If the queue is full, either the oldest action of the least urgent level (not more urgent than the new one)
+     * or the new action is dropped, see setTxQueueOverwrite()
+     * The memory owned by the action is freed in case it is dropped
+     * returns KNX_DEVICE_TX_QUEUE_FULL if the new action has been dropped
+     * The queueing time of the action is set
+     */
+    KnxDeviceStatus queueTxAction(TxAction& action);
+
+    /*
+     * Set the queueing time of a TX action, and turn its max. age into its expiry time
+     */
+    void stampTxAction(TxAction& action);
+
+    /*
+     * Queue a stamped TX action, see queueTxAction()
+     */
+    KnxDeviceStatus insertTxAction(TxAction& action);
+
+    /*
+     * Queue a TX action requested by the application (write, update) with a new id
+     */
+    KnxDeviceStatus queueRequestedTxAction(TxAction& action);
+
+    /*
+     * Replace the value of a write action still queued for the same com object
+     * Returns false if there is no such action (or coalescing is disabled)
+     */
+    bool coalesceWriteAction(const TxAction& action, byte level);
+
+    /*
+     * Send _txTelegram, as new telegram or as retry
+     */
+    void sendTxTelegram(void);
+
+    /*
+     * Schedule the retry of _txTelegram, or give it up once the max. nb of attempts is reached
+     */
+    void txTelegramFailed(TpUartTxAck outcome);
+
+    /*
+     * Start the transmission of the telegram built for a TX action
+     */
+    void startTxAction(const TxAction& action);
+
+    /*
+     * Notify the completion of a TX action (actions with id only)
+     */
+    void notifyTxCompletion(KnxTxActionId id, byte index, KnxTxOutcome outcome, unsigned long queueLatency, unsigned long busLatency);
+
+    /*
+     * Update the adaptive ACK timeout with the confirm latency of a sent telegram
+     */
+    void updateAckTimeout(unsigned long confirmLatency);
+
+    /*
+     * Returns true if the TX action is older than its max. age
+     */
+    bool isTxActionExpired(const TxAction& action) const;
+
+    /*
+     * Discard an expired TX action: a write still updates the com object value, without telegram
+     */
+    void expireTxAction(const TxAction& action);
+
+    /*
+     * Free the memory owned by a TX action which is dropped without being performed
+     */
+    void freeTxAction(const TxAction& action);
+
+    /*
+     * Send-on-change filter of a com object, NULL if none is active
+     */
+    KnxChangeFilter* getChangeFilter(byte index);
+
+    /*
+     * Returns true if the new value of a com object passes its send-on-change filter (or if it has none)
+     * Nothing is recorded: once the value has been queued, commitChangeFilter() makes it the last value passed
+     */
+    template <typename T> bool checkChangeFilter(byte index, T value);
+    template <typename T> void commitChangeFilter(byte index, T value);
+
+    /*
+     * Encode a value of the DPT into a TX action, returns KNX_DEVICE_ERROR if out of memory
+     */
+    template <KnxDpt dpt, typename T> static KnxDeviceStatus encodeTxValue(TxAction& action, T value, KnxDptLengthTag<false>);
+    template <KnxDpt dpt, typename T> static KnxDeviceStatus encodeTxValue(TxAction& action, T value, KnxDptLengthTag<true>);
+
+    /*
+     * Same for raw DPT values (equality only)
+     */
+    bool checkRawChangeFilter(byte index, const byte value[], byte length);
+    void commitRawChangeFilter(byte index, const byte value[], byte length);
+
+    /*
+     * Returns true if a numeric value differs enough from the last value passed (delta: distance to it, not 0)
+     */
+    bool exceedsThresholds(const KnxChangeFilter& filter, float delta, float lastValue) const;
+
+    /*
+     * Apply the min. interval of a filter to a value, and count the filtered values
+     * changed: false if the value does not differ (enough) from the last value passed
+     */
+    bool checkChange(KnxChangeFilter& filter, bool changed);
+
+    /*
+     * Read a long com object through its decoded value cache (see setReadCache())
+     */
+    template <typename T> KnxDeviceStatus readCached(byte index, T& returnedValue);
+
+    /*
+     * Queue a com object update, to be dispatched by task(), and flag the com object for nextDirty()
+     */
+    void comObjEvent(byte index, byte command);
+
+    /*
+     * Dispatch the queued com object updates, up to _maxEventsPerTask
+     * Returns true if updates are left
+     */
+    bool dispatchComObjEvents(void);
+
+    /*
+     * Call the application callback for a com object update
+     */
+    static void dispatchComObjEvent(byte index, byte command);
+
+    /*
+     * Enclose the com object value updates done by the KNX stack, so that the application
+     * can detect (and retry) reads overlapping an update (sequence lock)
+     */
+    void beginValueUpdate(void);
+    void endValueUpdate(void);
+
+    /*
+     * Start/end of a com object value read, endValueRead() returns false if the read has to be retried
+     */
+    word beginValueRead(void) const;
+    bool endValueRead(word seq) const;
+
+#if defined(KNX_RTOS_TASK)
+    /*
+     * Dispatch the TX completions passed by the KNX task
+     */
+    void dispatchTxCompletions(void);
+
+    /*
+     * Queue the TX actions handed over by the application, the dropped ones are notified as KNX_TX_DROPPED
+     */
+    void takeOverRtosTxActions(void);
+
+    /*
+     * Static function of the KNX task
+     */
+    static void rtosTaskLoop(void* device);
+#endif
+
+    /*
+     * Time (in usec) until task() needs to run again
+     */
+    unsigned long getTaskDelay(void);
+
+    /*
+     * Queue the cyclic transmission of a com object, unless a write on it is still queued
+     */
+    void queueCyclicWrite(byte index);
+
+    /*
+     * Static cyclicSendExpired() function called by _cyclicWheel
+     */
+    static void cyclicSendExpired(byte index);
+
     /*
      * Static getTpUartEvents() function called by the KnxTpUart layer (callback)
      */
@@ -238,4 +1055,91 @@ class KnxDevice {
 // Reference to the KnxDevice unique instance
 extern KnxDevice& Knx;
 
+// --------------- Definition of the DPT typed read/write functions -----------------
+// Instantiated by the application for its DPTs, so they are defined here
+
+template <KnxDpt dpt, typename T>
+KnxDeviceStatus KnxDevice::read(byte objectIndex, T& returnedValue) {
+    if ((objectIndex != 255) && (objectIndex >= _numberOfComObjects)) return KNX_DEVICE_INVALID_INDEX;
+    KnxComObject* comObj = (objectIndex == 255 ? &_progComObj : &_comObjectsList[objectIndex]);
+    if (comObj->getLength() != KnxDptTraits<dpt>::length) return KNX_DEVICE_ERROR;
+    byte dptValue[KnxDptTraits<dpt>::length > 2 ? KnxDptTraits<dpt>::length - 1 : 1];
+    word seq;
+    do {
+        seq = beginValueRead();
+        comObj->getValue(dptValue);
+    } while (!endValueRead(seq));
+    KnxDptTraits<dpt>::Codec::decode(dptValue, returnedValue);
+    return KNX_DEVICE_OK;
+}
+
+template <KnxDpt dpt, typename T>
+KnxDeviceStatus KnxDevice::write(byte objectIndex, T value, unsigned long maxAgeMillis) {
+    TxAction action;
+
+    if ((objectIndex != 255) && (objectIndex >= _numberOfComObjects)) return KNX_DEVICE_INVALID_INDEX;
+    KnxComObject* comObj = (objectIndex == 255 ? &_progComObj : &_comObjectsList[objectIndex]);
+    if (comObj->getLength() != KnxDptTraits<dpt>::length) return KNX_DEVICE_ERROR;
+    if (!comObj->isActive()) {
+        return KNX_DEVICE_COMOBJ_INACTIVE;
+    }
+    if (!checkChangeFilter(objectIndex, value)) return KNX_DEVICE_FILTERED;  // value not changed enough
+
+    KnxDeviceStatus status = encodeTxValue<dpt>(action, value, KnxDptLengthTag<(KnxDptTraits<dpt>::length > 2)>());
+    if (status != KNX_DEVICE_OK) return status;
+    // add WRITE action in the TX action queue
+    action.command = KNX_WRITE_REQUEST;
+    action.index = objectIndex;
+    action.expiryTimeMillis = maxAgeMillis;
+    status = queueRequestedTxAction(action);
+    if (status == KNX_DEVICE_OK) commitChangeFilter(objectIndex, value);
+    return status;
+}
+
+template <KnxDpt dpt, typename T>
+KnxDeviceStatus KnxDevice::encodeTxValue(TxAction& action, T value, KnxDptLengthTag<false>) {
+    KnxDptTraits<dpt>::Codec::encode(value, &action.byteValue);  // short object case
+    return KNX_DEVICE_OK;
+}
+
+template <KnxDpt dpt, typename T>
+KnxDeviceStatus KnxDevice::encodeTxValue(TxAction& action, T value, KnxDptLengthTag<true>) {
+    action.valuePtr = (byte*)malloc(KnxDptTraits<dpt>::length - 1);  // allocate the memory for DPT
+    if (!action.valuePtr) return KNX_DEVICE_ERROR;
+    KnxDptTraits<dpt>::Codec::encode(value, action.valuePtr);
+    return KNX_DEVICE_OK;
+}
+
+template <typename T>
+bool KnxDevice::checkChangeFilter(byte index, T value) {
+    KnxChangeFilter* filter = getChangeFilter(index);
+    if (!filter) return true;
+    byte kind = KnxIsIntegral<T>::value ? KNX_CHANGE_INTEGER : KNX_CHANGE_REAL;
+    if (filter->lastKind != kind) return checkChange(*filter, true);  // first value of this kind
+
+    if (KnxIsIntegral<T>::value) {
+        // exact for all integral types, also above 2^24 where floats lose precision
+        T lastValue = (T)filter->lastValue.integer;
+        unsigned long delta = (value > lastValue) ? (unsigned long)value - (unsigned long)lastValue
+                                                  : (unsigned long)lastValue - (unsigned long)value;
+        return checkChange(*filter, delta && exceedsThresholds(*filter, (float)delta, (float)lastValue));
+    }
+    double lastValue = filter->lastValue.real;
+    return checkChange(*filter, (value != lastValue) && exceedsThresholds(*filter, (float)fabs(value - lastValue), (float)lastValue));
+}
+
+template <typename T>
+void KnxDevice::commitChangeFilter(byte index, T value) {
+    KnxChangeFilter* filter = getChangeFilter(index);
+    if (!filter) return;
+    if (KnxIsIntegral<T>::value) {
+        filter->lastKind = KNX_CHANGE_INTEGER;
+        filter->lastValue.integer = (unsigned long)value;
+    } else {
+        filter->lastKind = KNX_CHANGE_REAL;
+        filter->lastValue.real = value;
+    }
+    filter->lastSendMillis = millis();
+}
+
 #endif // KNXDEVICE_H
@@ -0,0 +1,140 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KNXDPTCODEC_H
+#define KNXDPTCODEC_H
+
+#include "Arduino.h"
+#include "KnxDataPointTypes.h"
+
+// Pseudo format of the DPTs stored as short value (length <= 2, see KnxComObject)
+#define KNX_DPT_FORMAT_SHORT 0xFF
+
+/**
+ * Conversion between a DPT value (as in the telegram payload) and a standard C type, per DPT format.
+ *
+ * decode(const byte dpt[], T& result) and encode(T value, byte dpt[]) are straight-line code,
+ * used by ConvertFromDpt()/ConvertToDpt() at runtime and by the DPT typed KnxDevice::read()/write().
+ * Only the usual formats are supported (short values, U16, V16, U32, V32 and F16): the codec of
+ * any other format is not defined, so that its use does not compile.
+ */
+template <byte format>
+struct KnxDptCodec;
+
+template <>
+struct KnxDptCodec<KNX_DPT_FORMAT_SHORT> {
+    template <typename T>
+    static void decode(const byte dpt[], T& result) {
+        result = (T)dpt[0];
+    }
+    template <typename T>
+    static void encode(T value, byte dpt[]) {
+        dpt[0] = (byte)value;
+    }
+};
+
+template <>
+struct KnxDptCodec<KNX_DPT_FORMAT_U16> {
+    template <typename T>
+    static void decode(const byte dpt[], T& result) {
+        result = (T)(((unsigned int)dpt[0] << 8) | dpt[1]);  // converted once, like a cached value
+    }
+    template <typename T>
+    static void encode(T value, byte dpt[]) {
+        dpt[0] = (byte)((unsigned int)value >> 8);
+        dpt[1] = (byte)(value);
+    }
+};
+
+template <>
+struct KnxDptCodec<KNX_DPT_FORMAT_V16> : KnxDptCodec<KNX_DPT_FORMAT_U16> {};
+
+template <>
+struct KnxDptCodec<KNX_DPT_FORMAT_U32> {
+    template <typename T>
+    static void decode(const byte dpt[], T& result) {
+        // assembled before the conversion, so a float result is rounded once (as a cached value, see KnxDevice::setReadCache())
+        result = (T)(((unsigned long)dpt[0] << 24) | ((unsigned long)dpt[1] << 16) | ((unsigned long)dpt[2] << 8) | dpt[3]);
+    }
+    template <typename T>
+    static void encode(T value, byte dpt[]) {
+        dpt[0] = (byte)((unsigned long)value >> 24);
+        dpt[1] = (byte)((unsigned long)value >> 16);
+        dpt[2] = (byte)((unsigned long)value >> 8);
+        dpt[3] = (byte)(value);
+    }
+};
+
+template <>
+struct KnxDptCodec<KNX_DPT_FORMAT_V32> : KnxDptCodec<KNX_DPT_FORMAT_U32> {};
+
+template <>
+struct KnxDptCodec<KNX_DPT_FORMAT_F16> {
+    template <typename T>
+    static void decode(const byte dpt[], T& result) {
+        // Get the DPT sign, mantissa and exponent
+        int signMultiplier = (dpt[0] & 0x80) ? -1 : 1;
+        word absoluteMantissa = dpt[1] + ((dpt[0] & 0x07) << 8);
+        if (signMultiplier == -1) {  // Calculate absolute mantissa value in case of negative mantissa
+            // Abs = 2's complement + 1
+            absoluteMantissa = ((~absoluteMantissa) & 0x07FF) + 1;
+        }
+        byte exponent = (dpt[0] & 0x78) >> 3;
+        result = (T)(0.01 * ((long)absoluteMantissa << exponent) * signMultiplier);
+    }
+    template <typename T>
+    static void encode(T value, byte dpt[]) {
+        long longValuex100 = (long)(100.0 * value);
+        bool negativeSign = (longValuex100 & 0x80000000) ? true : false;
+        byte exponent = 0;
+        byte round = 0;
+
+        if (negativeSign) {
+            while (longValuex100 < (long)(-2048)) {
+                exponent++;
+                round = (byte)(longValuex100)&1;
+                longValuex100 >>= 1;
+                longValuex100 |= 0x80000000;
+            }
+        } else {
+            while (longValuex100 > (long)(2047)) {
+                exponent++;
+                round = (byte)(longValuex100)&1;
+                longValuex100 >>= 1;
+            }
+        }
+        if (round) longValuex100++;
+        dpt[1] = (byte)longValuex100;
+        dpt[0] = (byte)(longValuex100 >> 8) & 0x7;
+        dpt[0] += exponent << 3;
+        if (negativeSign) dpt[0] += 0x80;
+    }
+};
+
+/**
+ * Attributes of a DPT resolved at compile time
+ */
+template <KnxDpt dpt>
+struct KnxDptTraits {
+    enum {
+        length = knxDptLength(dpt),  // telegram data length (see KnxComObject::getLength())
+        format = KnxDptToFormat[dpt]
+    };
+    typedef KnxDptCodec<(length <= 2) ? KNX_DPT_FORMAT_SHORT : format> Codec;
+};
+
+#endif // KNXDPTCODEC_H
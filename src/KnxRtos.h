@@ -0,0 +1,156 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KNXRTOS_H
+#define KNXRTOS_H
+
+#include "Arduino.h"
+
+// !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
+// KNX_RTOS_TASK enables KnxDevice::startRtosTask(), which runs the KNX stack in a dedicated task.
+// It is available on ESP32 (FreeRTOS). -DKNX_RTOS_PTHREAD selects a POSIX threads variant instead,
+// built and tested on the host by extras/host_test (make test).
+#if defined(ESP32) || defined(KNX_RTOS_PTHREAD)
+#define KNX_RTOS_TASK
+#endif
+
+#if defined(KNX_RTOS_TASK)
+
+// Default core, priority and stack size (bytes) of the KNX task
+// Core 1 is the Arduino core on ESP32, WiFi runs on core 0. The priority is the one of loop() (1):
+// below one tick the task only yields between its RX/TX slots (see knxRtosWait()), which lets
+// loop() run at the same priority but would starve it at a higher one.
+#define KNX_RTOS_TASK_CORE 1
+#define KNX_RTOS_TASK_PRIORITY 1
+#define KNX_RTOS_TASK_STACK_SIZE 4096
+
+/*
+ * Minimal OS abstraction used by the KNX task: start a task, and a signal the task waits on
+ * with a timeout (in usec), raised by the application or an ISR to wake it up early.
+ */
+
+#if defined(ESP32)
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef TaskHandle_t KnxRtosTaskHandle;
+
+inline bool knxRtosStartTask(KnxRtosTaskHandle& handle, void (*function)(void*), void* arg, byte core, byte priority, word stackSize) {
+    return xTaskCreatePinnedToCore(function, "knx", stackSize, arg, priority, &handle, core) == pdPASS;
+}
+
+// Called by the task function itself when it is done
+inline void knxRtosExitTask(void) {
+    vTaskDelete(NULL);
+}
+
+// Wait until the task has exited, no join in FreeRTOS: poll the flag cleared by the task function
+inline void knxRtosJoinTask(KnxRtosTaskHandle&, volatile bool& running) {
+    while (running) vTaskDelay(1);
+}
+
+// Wake the task up (task or ISR context)
+inline void knxRtosSignal(KnxRtosTaskHandle handle) {
+    if (!handle) return;
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(handle, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    } else {
+        xTaskNotifyGive(handle);
+    }
+}
+
+// Wait for the signal at most timeoutMicros (called by the task itself)
+// Below one tick, the CPU is only yielded, so that the RX/TX slots are kept
+inline void knxRtosWait(KnxRtosTaskHandle, unsigned long timeoutMicros) {
+    if (timeoutMicros < portTICK_PERIOD_MS * 1000UL) {
+        taskYIELD();
+    } else {
+        ulTaskNotifyTake(pdTRUE, (timeoutMicros / 1000UL) / portTICK_PERIOD_MS);
+    }
+}
+
+#else // KNX_RTOS_PTHREAD
+
+#include <pthread.h>
+#include <time.h>
+
+typedef struct KnxRtosTaskHandle {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool signaled;
+    void (*function)(void*);
+    void* arg;
+} KnxRtosTaskHandle;
+
+inline void* knxRtosThreadEntry(void* handle) {
+    ((KnxRtosTaskHandle*)handle)->function(((KnxRtosTaskHandle*)handle)->arg);
+    return NULL;
+}
+
+// core and priority are ignored
+inline bool knxRtosStartTask(KnxRtosTaskHandle& handle, void (*function)(void*), void* arg, byte, byte, word) {
+    pthread_mutex_init(&handle.mutex, NULL);
+    pthread_cond_init(&handle.cond, NULL);
+    handle.signaled = false;
+    handle.function = function;
+    handle.arg = arg;
+    return pthread_create(&handle.thread, NULL, &knxRtosThreadEntry, &handle) == 0;
+}
+
+inline void knxRtosExitTask(void) {
+}
+
+inline void knxRtosJoinTask(KnxRtosTaskHandle& handle, volatile bool&) {
+    pthread_join(handle.thread, NULL);
+    pthread_cond_destroy(&handle.cond);
+    pthread_mutex_destroy(&handle.mutex);
+}
+
+inline void knxRtosSignal(KnxRtosTaskHandle& handle) {
+    pthread_mutex_lock(&handle.mutex);
+    handle.signaled = true;
+    pthread_cond_signal(&handle.cond);
+    pthread_mutex_unlock(&handle.mutex);
+}
+
+inline void knxRtosWait(KnxRtosTaskHandle& handle, unsigned long timeoutMicros) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (timeoutMicros > 1000000000UL) timeoutMicros = 1000000000UL;
+    deadline.tv_sec += timeoutMicros / 1000000UL;
+    deadline.tv_nsec += (timeoutMicros % 1000000UL) * 1000UL;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&handle.mutex);
+    while (!handle.signaled) {
+        if (pthread_cond_timedwait(&handle.cond, &handle.mutex, &deadline)) break;  // timeout
+    }
+    handle.signaled = false;
+    pthread_mutex_unlock(&handle.mutex);
+}
+
+#endif // ESP32
+
+#endif // KNX_RTOS_TASK
+
+#endif // KNXRTOS_H
@@ -0,0 +1,124 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "KnxTimerWheel.h"
+#include "DebugUtil.h"
+
+#define KNX_TIMER_WHEEL_MASK (KNX_TIMER_WHEEL_SLOTS - 1)
+
+KnxTimerWheel::KnxTimerWheel() {
+    _timers = NULL;
+    _timerNb = 0;
+    _current = 0;
+    for (byte s = 0; s < KNX_TIMER_WHEEL_SLOTS; s++) _slots[s] = KNX_TIMER_WHEEL_NONE;
+}
+
+KnxTimerWheel::~KnxTimerWheel() {
+    end();
+}
+
+bool KnxTimerWheel::begin(byte timerNb) {
+    end();
+    _timers = (Timer *)calloc(timerNb ? timerNb : 1, sizeof(Timer));
+    if (!_timers) {
+        DEBUG_PRINTLN(F("KnxTimerWheel: out of memory!"));
+        return false;
+    }
+    _timerNb = timerNb;
+    return true;
+}
+
+void KnxTimerWheel::end(void) {
+    free(_timers);
+    _timers = NULL;
+    _timerNb = 0;
+    _current = 0;
+    for (byte s = 0; s < KNX_TIMER_WHEEL_SLOTS; s++) _slots[s] = KNX_TIMER_WHEEL_NONE;
+}
+
+bool KnxTimerWheel::isActive(void) const {
+    return _timers != NULL;
+}
+
+void KnxTimerWheel::insert(byte id, word delay) {
+    byte slot = (_current + delay) & KNX_TIMER_WHEEL_MASK;
+    _timers[id].rounds = (delay - 1) / KNX_TIMER_WHEEL_SLOTS;
+    _timers[id].slot = slot;
+    _timers[id].next = _slots[slot];
+    _slots[slot] = id;
+}
+
+void KnxTimerWheel::unlink(byte id) {
+    byte *link = &_slots[_timers[id].slot];
+    while (*link != KNX_TIMER_WHEEL_NONE) {
+        if (*link == id) {
+            *link = _timers[id].next;
+            return;
+        }
+        link = &_timers[*link].next;
+    }
+}
+
+void KnxTimerWheel::schedule(byte id, word period, word delay) {
+    if (id >= _timerNb) return;
+    cancel(id);
+    if (!period) return;
+    if (!delay) delay = 1;
+    if (delay > period) delay = period;
+    _timers[id].period = period;
+    insert(id, delay);
+}
+
+void KnxTimerWheel::cancel(byte id) {
+    if ((id >= _timerNb) || !_timers[id].period) return;
+    unlink(id);
+    _timers[id].period = 0;
+}
+
+word KnxTimerWheel::getPeriod(byte id) const {
+    if (id >= _timerNb) return 0;
+    return _timers[id].period;
+}
+
+byte KnxTimerWheel::getTicksToNext(void) const {
+    for (byte ticks = 1; ticks <= KNX_TIMER_WHEEL_SLOTS; ticks++) {
+        if (_slots[(_current + ticks) & KNX_TIMER_WHEEL_MASK] != KNX_TIMER_WHEEL_NONE) return ticks;
+    }
+    return 0;
+}
+
+void KnxTimerWheel::tick(void (*expired)(byte id)) {
+    if (!_timers) return;
+    _current = (_current + 1) & KNX_TIMER_WHEEL_MASK;
+
+    // detach the slot list first, as timers may be linked into the same slot again
+    byte id = _slots[_current];
+    _slots[_current] = KNX_TIMER_WHEEL_NONE;
+    while (id != KNX_TIMER_WHEEL_NONE) {
+        byte next = _timers[id].next;
+        if (_timers[id].rounds) {
+            // expires in a later revolution
+            _timers[id].rounds--;
+            _timers[id].next = _slots[_current];
+            _slots[_current] = id;
+        } else {
+            insert(id, _timers[id].period);
+            expired(id);
+        }
+        id = next;
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KNXTIMERWHEEL_H
+#define KNXTIMERWHEEL_H
+
+#include "Arduino.h"
+#include "System.h"
+
+// !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
+// Nb of slots of the wheel (power of two), i.e. nb of ticks per revolution.
+// More slots mean less timers walked per tick, at the cost of one byte of RAM each.
+#if defined(KONNEKTING_SYSTEM_TYPE_DEFAULT)
+#define KNX_TIMER_WHEEL_SLOTS 64
+#else
+#define KNX_TIMER_WHEEL_SLOTS 16
+#endif
+
+#define KNX_TIMER_WHEEL_NONE 0xFF
+
+/**
+ * Hashed timer wheel for periodic timers, identified by a byte id (0..254).
+ *
+ * Each timer is linked into the slot it expires in, with the nb of whole
+ * revolutions still to wait. A tick only walks the timers of one slot, so
+ * the cost does not depend on the total nb of timers. Expired timers are
+ * rescheduled with their period, without drift.
+ */
+class KnxTimerWheel {
+
+    typedef struct Timer {
+        word period;    // in ticks, 0 = not scheduled
+        word rounds;    // nb of revolutions to wait before expiry
+        byte next;      // next timer in the same slot
+        byte slot;      // slot the timer is linked into
+    } Timer;
+
+    Timer *_timers;                          // per id
+    byte _timerNb;                           // nb of ids
+    byte _slots[KNX_TIMER_WHEEL_SLOTS];      // first timer per slot
+    byte _current;                           // slot of the last tick
+
+    // Link a timer into the slot it expires in after delay ticks (>= 1)
+    void insert(byte id, word delay);
+
+    // Unlink a timer from its slot
+    void unlink(byte id);
+
+  public:
+
+    KnxTimerWheel();
+    ~KnxTimerWheel();
+
+    /**
+     * Allocate the timers
+     * @param timerNb nb of ids, max. 255
+     * @return false if out of memory
+     */
+    bool begin(byte timerNb);
+
+    /**
+     * Free the timers
+     */
+    void end(void);
+
+    /**
+     * Returns true if begin() has been done successfully
+     */
+    bool isActive(void) const;
+
+    /**
+     * (Re)start a periodic timer
+     * @param id
+     * @param period in ticks, 0 stops the timer
+     * @param delay nb of ticks to the first expiry (phase), clamped to 1..period
+     */
+    void schedule(byte id, word period, word delay);
+
+    /**
+     * Stop a timer
+     * @param id
+     */
+    void cancel(byte id);
+
+    /**
+     * Get the period of a timer
+     * @param id
+     * @return period in ticks, 0 if the timer is stopped
+     */
+    word getPeriod(byte id) const;
+
+    /**
+     * Get the nb of ticks until the next slot holding timers is reached
+     * @return 1..KNX_TIMER_WHEEL_SLOTS, 0 if no timer is running
+     */
+    byte getTicksToNext(void) const;
+
+    /**
+     * Advance the wheel by one tick
+     * @param expired called with the id of each expired timer, must not (re)schedule or cancel timers
+     */
+    void tick(void (*expired)(byte id));
+};
+
+#endif // KNXTIMERWHEEL_H
@@ -43,10 +43,6 @@
  */
 //#define DEBUG
 
-static inline word TimeDeltaWord(word now, word before) {
-    return (word)(now - before);
-}
-
 
 // Constructor
 
@@ -65,10 +61,27 @@ KnxTpUart::KnxTpUart(HardwareSerial& serial, word physicalAddr, KnxTpUartMode mo
     _comObjectsList = NULL;
     _assignedComObjectsNb = 0;
     _stateIndication = 0;
-
-    _addressedComObjects.size = Konnekting._assocMaxTableEntries;
-    DEBUG_PRINTLN(F("Malloc maxaddressedComObj: %d"), _addressedComObjects.size);
-    _addressedComObjects.list = (byte*) malloc(_addressedComObjects.size * sizeof(byte));
+    _rxIsrMode = false;
+    _rxByteBudget = KNX_RX_BYTE_BUDGET;
+    _txBurstMode = false;
+    _txHandOverTime = 0;
+    _tx.startTimeMicros = 0;
+    _tx.sentTimeMicros = 0;
+    _txAckTimeout = KNX_TX_ACK_TIMEOUT;
+    _txConfirmLatency = 0;
+    _rx.readBytesNb = 0;
+    _rx.expectedTelegramLength = 0;
+    _rx.telegramCompletelyReceived = false;
+    _rx.lastByteTime = 0;
+    _rx.queueHead = 0;
+    _rx.queueItems = 0;
+    _rx.queueOverflowNb = 0;
+    _rx.busTelegramsNb = 0;
+
+    _progComObjIndex = 255;
+    _addressedComObjects.size = 0;
+    _addressedComObjects.items = 0;
+    _addressedComObjects.list = NULL;
 }
 
 // Destructor
@@ -84,8 +97,9 @@ KnxTpUart::~KnxTpUart() {
 // Return KNX_TPUART_ERROR in case of TPUART Reset failure
 
 byte KnxTpUart::reset(void) {
-    word startTime, nowTime;
+    unsigned long startTime;
     byte attempts = 10;
+    TpUartRxByte rxByte;
 
     DEBUG_PRINTLN(F("Reset triggered!"));
 
@@ -103,6 +117,7 @@ byte KnxTpUart::reset(void) {
     // TODO: why exactly swapping?? --> document here!
     _serial.swap();
 #endif
+    _rxRing.clear();
     while (attempts--) {  // we send a RESET REQUEST and wait for the reset indication answer
 
         DEBUG_PRINTLN(F("Reset attempts: %d"), attempts);
@@ -110,10 +125,11 @@ byte KnxTpUart::reset(void) {
         // the sequence is repeated every sec as long as we do not get the reset indication
         _serial.write(TPUART_RESET_REQ);  // send RESET REQUEST
 
-        for (nowTime = startTime = (word)millis(); TimeDeltaWord(nowTime, startTime) < 1000 /* 1 sec */; nowTime = (word)millis()) {
-            if (_serial.available() > 0) {
-                DEBUG_PRINTLN("Data available: %d", _serial.available());
-                byte data = _serial.read();
+        for (startTime = millis(); (millis() - startTime) < 1000 /* 1 sec */;) {
+            if (!_rxIsrMode) rxCollect();
+            if (_rxRing.pop(rxByte)) {
+                byte data = rxByte.data;
+                DEBUG_PRINTLN("Data available: 0x%02x", data);
                 if (data == TPUART_RESET_INDICATION) {
                     _rx.state = RX_INIT;
                     _tx.state = TX_INIT;
@@ -212,216 +228,342 @@ byte KnxTpUart::sendTelegram(KnxTelegram& sentTelegram) {
     _tx.nbRemainingBytes = sentTelegram.getTelegramLength();
     _tx.txByteIndex = 0;  // Set index to 0
     _tx.state = TX_TELEGRAM_SENDING_ONGOING;
+    _tx.startTimeMicros = micros();
+
+    // In burst mode, hand the telegram over right now unless the RX part has to send an ACK first
+    if (_txBurstMode && (_rx.state != RX_KNX_TELEGRAM_RECEPTION_STARTED)) txBurst();
     return KNX_TPUART_OK;
 }
 
+/*
+ * Burst mode: write as many control field/data byte pairs as the UART TX buffer can take
+ * (the whole telegram in most cases) in one go
+ */
+void KnxTpUart::txBurst(void) {
+    byte txBuffer[2 * KNX_TELEGRAM_MAX_SIZE];
+    byte length = 0;
+
+    // availableForWrite() returns 0 on cores not implementing it, send one pair at least
+    int nbPairs = _serial.availableForWrite() / 2;
+    if (nbPairs < 1) nbPairs = 1;
+    if (nbPairs > _tx.nbRemainingBytes) nbPairs = _tx.nbRemainingBytes;
+
+    while (nbPairs--) {
+        _tx.nbRemainingBytes--;
+        txBuffer[length++] = (_tx.nbRemainingBytes ? TPUART_DATA_START_CONTINUE_REQ : TPUART_DATA_END_REQ) + _tx.txByteIndex;
+        txBuffer[length++] = _tx.sentTelegram->readRawByte(_tx.txByteIndex);
+        _tx.txByteIndex++;
+    }
+    _serial.write(txBuffer, length);
+
+    if (!_tx.nbRemainingBytes) {
+        // Message sending completed
+        _tx.sentTimeMicros = micros();  // memorize sending time in order to manage ACK timeout
+        _txHandOverTime = _tx.sentTimeMicros - _tx.startTimeMicros;
+        _tx.state = TX_WAITING_ACK;
+    }
+}
+
+/*
+ * Collect all bytes available at the UART into the RX ring
+ * 
+ * Each byte is stamped with its reception time, so that End Of Packets can be
+ * detected by rxTask() independently from its calling period.
+ * In RX ISR mode, this function is called by a timer ISR or UART receive callback
+ * provided by the application, else it's called by rxTask() itself.
+ * If the ring is full, remaining bytes are left in the UART buffer.
+ * 
+ * DO NOT PUT ANY DEBUG PRINT CODE HERE! It might run in ISR context.
+ */
+byte KnxTpUart::rxCollect(void) {
+    TpUartRxByte rxByte;
+    byte collected = 0;
+
+    while (!_rxRing.isFull() && (_serial.available() > 0)) {
+        rxByte.data = (byte)(_serial.read());
+        rxByte.timestamp = micros();
+        _rxRing.push(rxByte);
+        collected++;
+    }
+    return collected;
+}
+
+/*
+ * Time (us) until rxTask()/txTask() need to run
+ */
+unsigned long KnxTpUart::getTaskDelay(void) {
+    unsigned long delay = KNX_TPUART_NO_DEADLINE;
+    unsigned long elapsed;
+
+    // received bytes waiting to be handled
+    if (_rxRing.getItemCount() || (!_rxIsrMode && (_serial.available() > 0))) return 0;
+
+    if (_rx.state > RX_IDLE_WAITING_FOR_CTRL_FIELD) {
+        // reception ongoing: without ISR, the next bytes have to be polled and stamped in time
+        if (!_rxIsrMode) return 0;
+        // with ISR, they wake us up, otherwise the EOP timeout ends the telegram
+        elapsed = micros() - _rx.lastByteTime;
+        delay = (elapsed >= KNX_RECEPTION_TIMEOUT) ? 0 : KNX_RECEPTION_TIMEOUT - elapsed;
+    }
+
+    switch (_tx.state) {
+        case TX_TELEGRAM_SENDING_ONGOING:
+            return 0;
+
+        case TX_WAITING_ACK:
+            // the confirm is UART activity, only its timeout has to be watched
+            elapsed = micros() - _tx.sentTimeMicros;
+            if (elapsed >= _txAckTimeout * 1000UL) return 0;
+            if (_txAckTimeout * 1000UL - elapsed < delay) delay = _txAckTimeout * 1000UL - elapsed;
+            break;
+
+        default: break;
+    }
+    return delay;
+}
+
 /*
  * Reception task
  * 
  * This function shall be called periodically in order to allow a correct reception of the KNX bus data
  * Assuming the TPUART speed is configured to 19200 baud, a character (8 data + 1 start + 1 parity + 1 stop)
  * is transmitted in 0,58ms.
- * In order not to miss any End Of Packets (i.e. a gap from 2 to 2,5ms), the function shall be called at a 
- * max period of 0,5ms.
- * Typical calling period is 400 usec.
+ * End Of Packets (i.e. a gap from 2 to 2,5ms) are detected with the reception time stored for each byte
+ * in the RX ring. If the ring is fed by rxTask() itself, the function shall be called at a 
+ * max period of 0,5ms. Typical calling period is 400 usec.
  * 
  * DO NOT PUT TOO MUCH DEBUG PRINT CODE HERE! Telegram receiving might break!
  */
 void KnxTpUart::rxTask(void) {
-    byte incomingByte;
-    word nowTime;
-    static bool telegramCompletelyReceived = false;
-    static byte expectedTelegramLength = 0;
-    static byte readBytesNb;                               // Nb of read bytes during an KNX telegram reception
-    static KnxTelegram telegram;                           // telegram being received
-    static word lastByteRxTimeMicrosec;
-
-    // === STEP 1 : Check EOP in case a Telegram is being received ===
-    if (_rx.state >= RX_KNX_TELEGRAM_RECEPTION_STARTED) {  // a telegram reception is ongoing
-
-        // word cast because a 65ms looping counter is long enough
-        nowTime = (word)micros();
-
-        if (TimeDeltaWord(nowTime, lastByteRxTimeMicrosec) > KNX_RECEPTION_TIMEOUT || telegramCompletelyReceived) { // EOP detected, the telegram reception is completed
-            //DEBUG_PRINTLN(F("EOP REACHED"));
-            telegramCompletelyReceived = false;
-            switch (_rx.state) {
-                case RX_KNX_TELEGRAM_RECEPTION_STARTED:  // we are not supposed to get EOP now, the telegram is incomplete
-                    //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_STARTED"));
-                case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID:
-                    //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID---"));
-                    _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
-                    //DEBUG_PRINTLN(F("TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR"));
-                    break;
-
-                case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
-                    //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_ADDRESSED"));
-                    if (telegram.isChecksumCorrect()) {
-                        // checksum correct, let's update the _rx struct with the received telegram and correct index
-                        //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_ADDRESSED 1"));
-                        telegram.copy(_rx.receivedTelegram);
-                        //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_ADDRESSED 2"));
-                        
-                        // Notify the new received telegram
-                        _evtCallbackFct(TPUART_EVENT_RECEIVED_KNX_TELEGRAM);
-                    } else {
-                        // checksum incorrect, notify error
-                        DEBUG_PRINTLN(F("checksum incorrect."));
-                        _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR);  // Notify telegram reception error
-                    }
-                    break;
+    TpUartRxByte rxByte;
+    byte budget = _rxByteBudget;
+
+    // the time has to be taken before looking into the ring: each byte found in there afterwards
+    // has been received before this time, or carries a later timestamp on its own
+    unsigned long nowTime = micros();
+
+    if (!_rxIsrMode) rxCollect();
+
+    while (budget--) {
+        if (!_rxRing.pop(rxByte)) {
+            // ring empty, look for bytes received in the meantime
+            nowTime = micros();
+            if (!_rxIsrMode) rxCollect();
+            if (!_rxRing.pop(rxByte)) {
+                // === Nothing received : Check EOP in case a Telegram is being received ===
+                rxCheckEop(nowTime);
+                return;
+            }
+        }
 
-                case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED:
-                    break;  // nothing to do!
+        // === STEP 1 : Check EOP in front of the new byte, based on its reception time ===
+        rxCheckEop(rxByte.timestamp);
 
-                default:
-                    break;
-            }  // end of switch
+        // === STEP 2 : Handle the new RX Data ===
+        if (!rxHandleByte(rxByte)) return;  // TPUART reset, the remaining bytes are obsolete
 
-            // we move state back to RX IDLE in any case
-            _rx.state = RX_IDLE_WAITING_FOR_CTRL_FIELD;
-        }  // end EOP detected
+        // a complete telegram can be handled right now, no need to wait for the gap
+        if (_rx.telegramCompletelyReceived) rxCheckEop(rxByte.timestamp);
     }
+}
 
-    // === STEP 2 : Get New RX Data ===
-    if (_serial.available() > 0) {
-        incomingByte = (byte)(_serial.read());
-        lastByteRxTimeMicrosec = (word)micros();
-        //DEBUG_PRINTLN(F("RX:  incomingByte=0x%02x, readBytesNb=%d"), incomingByte, readBytesNb);
+/*
+ * Check if the telegram being received is completed at the given time.
+ * If so, the telegram is handled and the RX state goes back to IDLE
+ */
+void KnxTpUart::rxCheckEop(unsigned long nowTime) {
+    if (_rx.state < RX_KNX_TELEGRAM_RECEPTION_STARTED) return;  // no telegram reception ongoing
 
+    if ((nowTime - _rx.lastByteTime) > KNX_RECEPTION_TIMEOUT || _rx.telegramCompletelyReceived) { // EOP detected, the telegram reception is completed
+        //DEBUG_PRINTLN(F("EOP REACHED"));
+        _rx.telegramCompletelyReceived = false;
+        _rx.busTelegramsNb++;
         switch (_rx.state) {
-            case RX_IDLE_WAITING_FOR_CTRL_FIELD:
-                //DEBUG_PRINTLN(F("RX_IDLE_WAITING_FOR_CTRL_FIELD \nincomingByte=0x%02x, readBytesNb=%d"), incomingByte, readBytesNb);
-
-                // CASE OF KNX MESSAGE
-                if ((incomingByte & KNX_CONTROL_FIELD_PATTERN_MASK) == KNX_CONTROL_FIELD_VALID_PATTERN) {
-                    _rx.state = RX_KNX_TELEGRAM_RECEPTION_STARTED;
-                    readBytesNb = 1;
-                    telegram.writeRawByte(incomingByte, 0);
-                    //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_STARTED"));
-                } 
-                // CASE OF TPUART_DATA_CONFIRM_SUCCESS NOTIFICATION
-                else if (incomingByte == TPUART_DATA_CONFIRM_SUCCESS) {
-                    if (_tx.state == TX_WAITING_ACK) {
-                        _tx.ackFctPtr(ACK_RESPONSE);
-                        _tx.state = TX_IDLE;
+            case RX_KNX_TELEGRAM_RECEPTION_STARTED:  // we are not supposed to get EOP now, the telegram is incomplete
+                //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_STARTED"));
+            case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID:
+                //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID---"));
+                _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
+                //DEBUG_PRINTLN(F("TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR"));
+                break;
+
+            case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
+                //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_ADDRESSED"));
+                if (_rx.telegram.isChecksumCorrect()) {
+                    // checksum correct, let's queue the received telegram with the addressed com objects
+                    // The application gets it with getReceivedTelegram() / releaseReceivedTelegram()
+                    if (_rx.queueItems < KNX_RX_TELEGRAM_QUEUE_SIZE) {
+                        TpUartRxTelegram& slot = _rx.queue[(_rx.queueHead + _rx.queueItems) % KNX_RX_TELEGRAM_QUEUE_SIZE];
+                        _rx.telegram.copy(slot.telegram);
+                        slot.addressedComObjects = _addressedComObjects;
+                        _rx.queueItems++;
                     } else {
-                        //DEBUG_PRINTLN(F("Rx: unexpected TPUART_DATA_CONFIRM_SUCCESS received!"));
-                    }
-                }
-                // CASE OF TPUART_RESET NOTIFICATION
-                else if (incomingByte == TPUART_RESET_INDICATION) {
-                    if ((_tx.state == TX_TELEGRAM_SENDING_ONGOING) || (_tx.state == TX_WAITING_ACK)) {  // response to the TP UART transmission
-                        _tx.ackFctPtr(TPUART_RESET_RESPONSE);
+                        _rx.queueOverflowNb++;
+                        DEBUG_PRINTLN(F("RX queue full, telegram lost."));
                     }
-                    _tx.state = TX_STOPPED;
-                    _rx.state = RX_STOPPED;
-                    // Notify RESET
-                    _evtCallbackFct(TPUART_EVENT_RESET);
-                    //DEBUG_PRINTLN(F("Rx: Reset Indication Received"));
-                    return;
-                }
-                // CASE OF STATE_INDICATION RESPONSE
-                else if ((incomingByte & TPUART_STATE_INDICATION_MASK) == TPUART_STATE_INDICATION) {
-                    _evtCallbackFct(TPUART_EVENT_STATE_INDICATION);  // Notify STATE INDICATION
-                    _stateIndication = incomingByte;
-                    //DEBUG_PRINTLN(F("Rx: State Indication Received"));
+                } else {
+                    // checksum incorrect, notify error
+                    DEBUG_PRINTLN(F("checksum incorrect."));
+                    _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR);  // Notify telegram reception error
                 }
-                // CASE OF TPUART_DATA_CONFIRM_FAILED NOTIFICATION
-                else if (incomingByte == TPUART_DATA_CONFIRM_FAILED) {
-                    // NACK following Telegram transmission
-                    if (_tx.state == TX_WAITING_ACK) {
-                        _tx.ackFctPtr(NACK_RESPONSE);
-                        _tx.state = TX_IDLE;
-                    } else
-                        DEBUG_PRINTLN(F("Rx: unexpected TPUART_DATA_CONFIRM_FAILED received!"));
+                break;
+
+            case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED:
+                break;  // nothing to do!
+
+            default:
+                break;
+        }  // end of switch
+
+        // we move state back to RX IDLE in any case
+        _rx.state = RX_IDLE_WAITING_FOR_CTRL_FIELD;
+    }  // end EOP detected
+}
+
+/*
+ * Run the RX state machine with one received byte
+ * Returns false if the byte was a TPUART reset indication
+ */
+boolean KnxTpUart::rxHandleByte(const TpUartRxByte& rxByte) {
+    byte incomingByte = rxByte.data;
+    _rx.lastByteTime = rxByte.timestamp;
+    //DEBUG_PRINTLN(F("RX:  incomingByte=0x%02x, readBytesNb=%d"), incomingByte, _rx.readBytesNb);
+
+    switch (_rx.state) {
+        case RX_IDLE_WAITING_FOR_CTRL_FIELD:
+            //DEBUG_PRINTLN(F("RX_IDLE_WAITING_FOR_CTRL_FIELD \nincomingByte=0x%02x, readBytesNb=%d"), incomingByte, _rx.readBytesNb);
+
+            // CASE OF KNX MESSAGE
+            if ((incomingByte & KNX_CONTROL_FIELD_PATTERN_MASK) == KNX_CONTROL_FIELD_VALID_PATTERN) {
+                _rx.state = RX_KNX_TELEGRAM_RECEPTION_STARTED;
+                _rx.readBytesNb = 1;
+                _rx.telegram.writeRawByte(incomingByte, 0);
+                //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_STARTED"));
+            } 
+            // CASE OF TPUART_DATA_CONFIRM_SUCCESS NOTIFICATION
+            else if (incomingByte == TPUART_DATA_CONFIRM_SUCCESS) {
+                if (_tx.state == TX_WAITING_ACK) {
+                    _txConfirmLatency = rxByte.timestamp - _tx.sentTimeMicros;
+                    _tx.ackFctPtr(ACK_RESPONSE);
+                    _tx.state = TX_IDLE;
+                } else {
+                    //DEBUG_PRINTLN(F("Rx: unexpected TPUART_DATA_CONFIRM_SUCCESS received!"));
                 }
-                // UNKNOWN CONTROL FIELD RECEIVED
-                else if (incomingByte) {
-                    //DEBUG_PRINTLN(F("Rx: Unknown Control Field received: byte=0x%02x"), incomingByte);
+            }
+            // CASE OF TPUART_RESET NOTIFICATION
+            else if (incomingByte == TPUART_RESET_INDICATION) {
+                if ((_tx.state == TX_TELEGRAM_SENDING_ONGOING) || (_tx.state == TX_WAITING_ACK)) {  // response to the TP UART transmission
+                    _tx.ackFctPtr(TPUART_RESET_RESPONSE);
                 }
-                // else ignore "0" value sent on Reset by TPUART prior to TPUART_RESET_INDICATION
-                break;
+                _tx.state = TX_STOPPED;
+                _rx.state = RX_STOPPED;
+                // Notify RESET
+                _evtCallbackFct(TPUART_EVENT_RESET);
+                //DEBUG_PRINTLN(F("Rx: Reset Indication Received"));
+                return false;
+            }
+            // CASE OF STATE_INDICATION RESPONSE
+            else if ((incomingByte & TPUART_STATE_INDICATION_MASK) == TPUART_STATE_INDICATION) {
+                _evtCallbackFct(TPUART_EVENT_STATE_INDICATION);  // Notify STATE INDICATION
+                _stateIndication = incomingByte;
+                //DEBUG_PRINTLN(F("Rx: State Indication Received"));
+            }
+            // CASE OF TPUART_DATA_CONFIRM_FAILED NOTIFICATION
+            else if (incomingByte == TPUART_DATA_CONFIRM_FAILED) {
+                // NACK following Telegram transmission
+                if (_tx.state == TX_WAITING_ACK) {
+                    _txConfirmLatency = rxByte.timestamp - _tx.sentTimeMicros;
+                    _tx.ackFctPtr(NACK_RESPONSE);
+                    _tx.state = TX_IDLE;
+                } else
+                    DEBUG_PRINTLN(F("Rx: unexpected TPUART_DATA_CONFIRM_FAILED received!"));
+            }
+            // UNKNOWN CONTROL FIELD RECEIVED
+            else if (incomingByte) {
+                //DEBUG_PRINTLN(F("Rx: Unknown Control Field received: byte=0x%02x"), incomingByte);
+            }
+            // else ignore "0" value sent on Reset by TPUART prior to TPUART_RESET_INDICATION
+            break;
 
-            case RX_KNX_TELEGRAM_RECEPTION_STARTED:
-                //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_STARTED incomingByte=0x%02x, readBytesNb=%d"), incomingByte, readBytesNb);
-                telegram.writeRawByte(incomingByte, readBytesNb);
-                readBytesNb++;
+        case RX_KNX_TELEGRAM_RECEPTION_STARTED:
+            //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_STARTED incomingByte=0x%02x, readBytesNb=%d"), incomingByte, _rx.readBytesNb);
+            _rx.telegram.writeRawByte(incomingByte, _rx.readBytesNb);
+            _rx.readBytesNb++;
 
-                //we should try to comment out this check, because we can send telegrams that should be received by own self
-                if (readBytesNb == 3) { // We have just received the source address
+            //we should try to comment out this check, because we can send telegrams that should be received by own self
+            if (_rx.readBytesNb == 3) { // We have just received the source address
 
-                    // we check whether the received KNX telegram is coming from us (i.e. telegram is sent by the TPUART itself)
-                    if (telegram.getSourceAddress() == _physicalAddr) {
-                        // the message is coming from us, we consider it as not addressed and we don't send any ACK service
-                        //DEBUG_PRINTLN(F("message from us, skip."));
-                        _rx.state = RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
-                    }
-                } else if (readBytesNb == 6)
-                // We have just read the routing field containing the address type and the payload length
-                {
+                // we check whether the received KNX telegram is coming from us (i.e. telegram is sent by the TPUART itself)
+                if (_rx.telegram.getSourceAddress() == _physicalAddr) {
+                    // the message is coming from us, we consider it as not addressed and we don't send any ACK service
+                    //DEBUG_PRINTLN(F("message from us, skip."));
+                    _rx.state = RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
+                }
+            } else if (_rx.readBytesNb == 6)
+            // We have just read the routing field containing the address type and the payload length
+            {
 
-                    // Telegram length is payload length + 7 bytes "overhead"
-                    expectedTelegramLength = (incomingByte & KNX_PAYLOAD_LENGTH_MASK) + 7;
+                // Telegram length is payload length + 7 bytes "overhead"
+                _rx.expectedTelegramLength = (incomingByte & KNX_PAYLOAD_LENGTH_MASK) + 7;
 
-                    // We check if the message is addressed to us in order to send the appropriate acknowledge
-                    if (isAddressAssigned(telegram.getTargetAddress() /*, addressedComObjIndex*/)) {  // Message addressed to us
+                // We check if the message is addressed to us in order to send the appropriate acknowledge
+                if (isAddressAssigned(_rx.telegram.getTargetAddress() /*, addressedComObjIndex*/)) {  // Message addressed to us
 
-                        // DEBUG_PRINTLN(F("assigned to us: ga=0x%04x index=%d"), telegram.GetTargetAddress(), addressedComObjectIndex);
+                    // DEBUG_PRINTLN(F("assigned to us: ga=0x%04x index=%d"), telegram.GetTargetAddress(), addressedComObjectIndex);
 
-                        _rx.state = RX_KNX_TELEGRAM_RECEPTION_ADDRESSED;
-                        // sent the correct ACK service now
-                        // the ACK info must be sent latest 1,7 ms after receiving the address type octet of an addressed frame
-                        _serial.write(TPUART_RX_ACK_SERVICE_ADDRESSED);
+                    _rx.state = RX_KNX_TELEGRAM_RECEPTION_ADDRESSED;
+                    // sent the correct ACK service now
+                    // the ACK info must be sent latest 1,7 ms after receiving the address type octet of an addressed frame
+                    _serial.write(TPUART_RX_ACK_SERVICE_ADDRESSED);
 
-                        // dirty workaround for sending ACk just before reset?
-                        // _serial.flush();
+                    // dirty workaround for sending ACk just before reset?
+                    // _serial.flush();
 
-                    } else {  // Message NOT addressed to us
-                        _rx.state = RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
-                        //sent the correct ACK service now
-                        // the ACK info must be sent latest 1,7 ms after receiving the address type octet of an addressed frame
-                        _serial.write(TPUART_RX_ACK_SERVICE_NOT_ADDRESSED);
+                } else {  // Message NOT addressed to us
+                    _rx.state = RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
+                    //sent the correct ACK service now
+                    // the ACK info must be sent latest 1,7 ms after receiving the address type octet of an addressed frame
+                    _serial.write(TPUART_RX_ACK_SERVICE_NOT_ADDRESSED);
 
-                        // dirty workaround for sending ACk just before reset?
-                        // _serial.flush();
-                    }
+                    // dirty workaround for sending ACk just before reset?
+                    // _serial.flush();
                 }
-                break;
+            }
+            break;
 
-            case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
+        case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
 
-                //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_ADDRESSED"));
+            //DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_ADDRESSED"));
 
-                if (readBytesNb == KNX_TELEGRAM_MAX_SIZE) {
-                    _rx.state = RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID;
-                    DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID"));
+            if (_rx.readBytesNb == KNX_TELEGRAM_MAX_SIZE) {
+                _rx.state = RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID;
+                DEBUG_PRINTLN(F("RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID"));
+            } else {
+                _rx.telegram.writeRawByte(incomingByte, _rx.readBytesNb);
+                 //DEBUG_PRINTLN(F("expectedTelegramLength: %d, readBytesNb: %d"),_rx.expectedTelegramLength,_rx.readBytesNb);
+                if (_rx.expectedTelegramLength == _rx.readBytesNb) {
+                    _rx.telegramCompletelyReceived = true;
+                    //we are done with reception
+//                        DEBUG_PRINTLN(F("we are done, telegramCompletelyReceived: %d"),_rx.telegramCompletelyReceived);
                 } else {
-                    telegram.writeRawByte(incomingByte, readBytesNb);
-                     //DEBUG_PRINTLN(F("expectedTelegramLength: %d, readBytesNb: %d"),expectedTelegramLength,readBytesNb);
-                    if (expectedTelegramLength == readBytesNb) {
-                        telegramCompletelyReceived = true;
-                        //we are done with reception
-//                        DEBUG_PRINTLN(F("we are done, telegramCompletelyReceived: %d"),telegramCompletelyReceived);
-                    } else {
-                        
-                        readBytesNb++;
-                    }
+                    
+                    _rx.readBytesNb++;
                 }
-                break;
+            }
+            break;
 
-            // if the message is too long, nothing to do except waiting for EOP
-            case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID:
-                break;
+        // if the message is too long, nothing to do except waiting for EOP
+        case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID:
+            break;
 
-            // if the message is not addressed, nothing to do except waiting for EOP
-            case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED:
-                break;
+        // if the message is not addressed, nothing to do except waiting for EOP
+        case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED:
+            break;
 
-            default:
-                break;
-        }  // end of: switch (_rx.state)
-    }      // end of: if (_serial.available() > 0)
+        default:
+            break;
+    }  // end of: switch (_rx.state)
+    return true;
 }
 
 /**
@@ -434,16 +576,13 @@ void KnxTpUart::rxTask(void) {
  * Typical calling period is 800 usec.
  */
 void KnxTpUart::txTask(void) {
-    word nowTime;
     byte txByte[2];
-    static word sentMessageTimeMillisec;
 
     // STEP 1 : Manage Message Acknowledge timeout
     switch (_tx.state) {
         case TX_WAITING_ACK:
             // A transmission ACK is awaited, increment Acknowledge timeout
-            nowTime = (word)millis();                                                  // word is enough to count up to 500
-            if (TimeDeltaWord(nowTime, sentMessageTimeMillisec) > 500 /* 500 ms */) {  // The no-answer timeout value is defined as follows :
+            if ((micros() - _tx.sentTimeMicros) > _txAckTimeout * 1000UL) {  // The default no-answer timeout value (500ms) is defined as follows :
                 // - The emission duration for a single max sized telegram is 40ms
                 // - The telegram emission might be repeated 3 times (120ms)
                 // - The telegram emission might be delayed by another message transmission ongoing
@@ -460,14 +599,17 @@ void KnxTpUart::txTask(void) {
             // we block the transmission (for around 3,3ms) till the ACK is sent
             // In that way, the TX buffer will remain empty and the ACK will be sent immediately
             if (_rx.state != RX_KNX_TELEGRAM_RECEPTION_STARTED) {
-                if (_tx.nbRemainingBytes == 1) {  // We are sending the last byte, i.e checksum
+                if (_txBurstMode) {
+                    txBurst();
+                } else if (_tx.nbRemainingBytes == 1) {  // We are sending the last byte, i.e checksum
                     txByte[0] = TPUART_DATA_END_REQ + _tx.txByteIndex;
                     txByte[1] = _tx.sentTelegram->readRawByte(_tx.txByteIndex);
                     //DEBUG_PRINTLN(F("data1[%d]=0x%02x"),_tx.txByteIndex, txByte[1]);
                     _serial.write(txByte, 2);  // write the UART control field and the data byte
 
                     // Message sending completed
-                    sentMessageTimeMillisec = (word)millis();  // memorize sending time in order to manage ACK timeout
+                    _tx.sentTimeMicros = micros();  // memorize sending time in order to manage ACK timeout
+                    _txHandOverTime = _tx.sentTimeMicros - _tx.startTimeMicros;
                     _tx.state = TX_WAITING_ACK;
                 } else {
                     txByte[0] = TPUART_DATA_START_CONTINUE_REQ + _tx.txByteIndex;
@@ -491,16 +633,21 @@ void KnxTpUart::txTask(void) {
  * Typical calling period is 400 usec.
  */
 boolean KnxTpUart::getMonitoringData(MonitorData& data) {
-    word nowTime;
+    TpUartRxByte rxByte;
     static MonitorData currentData = {true, 0};
-    static word lastByteRxTimeMicrosec;
+    static unsigned long lastByteRxTimeMicrosec;
 
-    // STEP 1 : Check EOP
+    // time is taken before looking into the ring, see rxTask()
+    unsigned long nowTime = micros();
+
+    if (!_rxIsrMode) rxCollect();
+    boolean received = _rxRing.peek(rxByte);
+
+    // STEP 1 : Check EOP, in front of the new data if any
     if (!(currentData.isEOP))  // check that we have not already detected an EOP
     {
-        // word cast because a 65ms counter is enough
-        nowTime = (word)micros();
-        if (TimeDeltaWord(nowTime, lastByteRxTimeMicrosec) > 2000 /* 2 ms */) {  // EOP detected
+        if (received) nowTime = rxByte.timestamp;
+        if ((nowTime - lastByteRxTimeMicrosec) > 2000 /* 2 ms */) {  // EOP detected, new data is returned with next call
             currentData.isEOP = true;
             currentData.dataByte = 0;
             data = currentData;
@@ -508,11 +655,12 @@ boolean KnxTpUart::getMonitoringData(MonitorData& data) {
         }
     }
     // STEP 2 : Get New RX Data
-    if (_serial.available() > 0) {
-        currentData.dataByte = (byte)(_serial.read());
+    if (received) {
+        _rxRing.pop(rxByte);
+        currentData.dataByte = rxByte.data;
         currentData.isEOP = false;
         data = currentData;
-        lastByteRxTimeMicrosec = (word)micros();
+        lastByteRxTimeMicrosec = rxByte.timestamp;
         return true;
     }
     return false;  // No data received
@@ -530,9 +678,6 @@ boolean KnxTpUart::getMonitoringData(MonitorData& data) {
  * @return true if assigned & active, false if not
  */
 boolean KnxTpUart::isAddressAssigned(word addr) {
-    long start = micros();
-    DEBUG_PRINTLN(F("isAddressAssigned: Searching for 0x%04x"), addr);
-
     // clean up old findings
     _addressedComObjects.items = 0;
 
@@ -541,126 +686,20 @@ boolean KnxTpUart::isAddressAssigned(word addr) {
 
     // in case of Programming Group Address, we also return immediately
     if (addr == 0x7fff) {     // 0x7fff = 15/7/255
-        _addressedComObjects.list[0] = 255;  // set ProgComObj
+        _addressedComObjects.list = &_progComObjIndex;  // set ProgComObj
+        _addressedComObjects.size = 1;
         _addressedComObjects.items = 1;
-        DEBUG_PRINTLN(F("  0x%04x == 0x7fff --> progComObj. [%dus]"), addr, (micros() - start));
         return true;
     }
 
-    // search for adressid in address table
-    AddressTable addressTable = Konnekting._addressTable;
-    byte l = 0;                                    // left end of array
-    byte r = addressTable.size - 1;  // right end of array
-    boolean addressFound = false;                  // true if address found in address table
-    byte addressId;                                // address-id of groupaddress in address table
-
-    // do binary search in address table
-    while (l <= r) {
-        byte m = l + (r - l) / 2;  // mid
-
-        // Check if 'addr' is present at mid
-        if (addressTable.address[m] == addr) {
-            addressFound = true;
-            addressId = m;
-            break;
-        }
-
-        // If 'addr' greater, ignore left half by setting l to next right from mid
-        if (addr > addressTable.address[m]) {
-            l = m + 1;
-        } else {
-            // 'addr' is smaller, so ignore right half by setting r to next left from mid
-            r = m - 1;
-        }
-    }
-    if (!addressFound) {
-        DEBUG_PRINTLN(F("  0x%04x not in addr table. [%dus]"), addr, (micros() - start));
-        return false;  // address unknown
-    } else {
-        DEBUG_PRINTLN(F("  0x%04x has id #%d"), addr, addressId);
-    }
-
-    // get the assoc table from konnkting. We handle them as two arrays
-    // to make search for GA easier, as we can search in an
-    // AddressId-Array-Only for the matching index and can use the ComObj
-    // array to get the ComObjID based on the found index
-    AssociationTable associationTable = Konnekting._associationTable;
-
-    // inspired by https://www.geeksforgeeks.org/binary-search/
-    l = 0;                          // left end of array
-    r = associationTable.size - 1;  // right end of array
-
-    // some helper variables for doing iterative binary search
-    int addressIdOnIndex = 0;
-    boolean addressIdFound = false;
-
-    // do binary search in assoc table
-    while (l <= r) {
-        byte m = l + (r - l) / 2;  // mid
-
-        // Check if 'addressId' is present at mid
-        if (associationTable.gaId[m] == addressId) {
-            addressIdFound = true;
-            addressIdOnIndex = m;
-            break;
-        }
-
-        // If 'addressId' greater, ignore left half by setting l to next right from mid
-        if (addressId > associationTable.gaId[m]) {
-            l = m + 1;
-        } else {
-            // 'addressId' is smaller, so ignore right half by setting r to next left from mid
-            r = m - 1;
-        }
-    }
-
-    byte listIndex = 0;
+    // the com objects associated to a GA are a contiguous range in the index
+    byte* list;
+    byte items = Konnekting._addressIndex.find(addr, list);
+    if (!items) return false;
 
-    if (addressIdFound) {
-        DEBUG_PRINTLN(F("  addrID=%d found on assoc table index %d"), addressId, addressIdOnIndex);
-
-        // add first occurence
-        _addressedComObjects.list[listIndex] = associationTable.coId[addressIdOnIndex];
-        _addressedComObjects.items++;
-        listIndex++;
-
-        // search backwards until other address gets visible
-        byte i = addressIdOnIndex - 1;
-
-        if (i > 0) {
-            while (associationTable.gaId[i] == addressId) {
-                DEBUG_PRINTLN(F("    found prev index: %d"), i);
-
-                _addressedComObjects.list[listIndex] = associationTable.coId[i];
-                _addressedComObjects.items++;
-                listIndex++;
-
-                i--;
-            }
-        }
-
-        // search forward until other address gets visible
-        i = addressIdOnIndex + 1;
-        if (i < associationTable.size - 1) {
-            while (associationTable.gaId[i] == addressId) {
-                DEBUG_PRINTLN(F("    found next index: %d"), i);
-                _addressedComObjects.list[listIndex] = associationTable.coId[i];
-                _addressedComObjects.items++;
-                listIndex++;
-
-                i++;
-            }
-        }
-    }
-
-    boolean foundSomeIndex = _addressedComObjects.items > 0;
-
-    if (!foundSomeIndex) {
-        DEBUG_PRINTLN(F("IsAddressAssigned: found nothing, skipping this GA"), addr);
-    } else {
-        DEBUG_PRINTLN(F("IsAddressAssigned: found %d matching ComObjs"), _addressedComObjects.items);
-    }
-    DEBUG_PRINTLN(F("IsAddressAssigned: [%dus]"), (micros() - start));
-    return foundSomeIndex;
+    _addressedComObjects.list = list;
+    _addressedComObjects.size = items;
+    _addressedComObjects.items = items;
+    return true;
 }
 //EOF
@@ -23,6 +23,7 @@
 #include "HardwareSerial.h"
 #include "KnxTelegram.h"
 #include "KnxComObject.h"
+#include "LockFreeRingBuff.h"
 #include "System.h"
 
 
@@ -83,6 +84,22 @@
 #define KNX_RECEPTION_TIMEOUT 2000
 #endif
 
+// Value returned by getTaskDelay() when only UART activity needs the tasks to run
+#define KNX_TPUART_NO_DEADLINE 0xFFFFFFFFUL
+
+// Default time (ms) to wait for the TPUART confirm of a sent telegram (see setAckTimeout())
+#define KNX_TX_ACK_TIMEOUT 500
+
+// Size of the ring buffer holding the received bytes (and their reception time) until rxTask() handles them.
+// Must be a power of two, max. 128
+#define KNX_RX_RING_SIZE 32
+
+// Default max. nb of received bytes handled by one rxTask() call (see setRxByteBudget())
+#define KNX_RX_BYTE_BUDGET KNX_RX_RING_SIZE
+
+// Nb of received telegrams that can be queued until KnxDevice::task() handles them
+#define KNX_RX_TELEGRAM_QUEUE_SIZE 4
+
 // Definition of the TP-UART working modes
 enum KnxTpUartMode { NORMAL,
                           BUS_MONITOR };
@@ -90,7 +107,7 @@ enum KnxTpUartMode { NORMAL,
 // Definition of the TP-UART events sent to the application layer
 enum KnxTpUartEvent { 
   TPUART_EVENT_RESET = 0,                    // 0: reset received from the TPUART device
-  TPUART_EVENT_RECEIVED_KNX_TELEGRAM,        // 1: a new addressed KNX Telegram has been received
+  TPUART_EVENT_RECEIVED_KNX_TELEGRAM,        // 1: a new addressed KNX Telegram has been received (queued, see getReceivedTelegram())
   TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR, // 2: a new addressed KNX telegram reception failed
   TPUART_EVENT_STATE_INDICATION              // 3: new TPUART state indication received
  };
@@ -114,13 +131,33 @@ enum TpUartRxState {
 typedef struct AddressedComObjects {
   byte size; // total size of list, incl. empty cells
   byte items; // size if items in list
-  byte* list; // the list/array if indizes of addressed comcobjects
+  byte* list; // the list/array if indizes of addressed comcobjects, points into Konnekting._addressIndex
 } AddressedComObjects;
 
+// A byte received from the TPUART, together with its reception time
+typedef struct TpUartRxByte {
+  byte data;                  // Received byte
+  unsigned long timestamp;    // micros() value when the byte has been taken from the UART
+} TpUartRxByte;
+
+// A received telegram, together with the com objects it addresses
+typedef struct TpUartRxTelegram {
+  KnxTelegram telegram;
+  AddressedComObjects addressedComObjects;
+} TpUartRxTelegram;
+
 typedef struct TpUartRx {
   TpUartRxState state;        // Current TPUART RX state
-  KnxTelegram receivedTelegram; // Where each received telegram is stored (the content is overwritten on each telegram reception)
-                                // A TPUART_EVENT_RECEIVED_KNX_TELEGRAM event notifies each content change
+  TpUartRxTelegram queue[KNX_RX_TELEGRAM_QUEUE_SIZE]; // Received telegrams, not yet released by the application
+  byte queueHead;               // Index of the oldest queued telegram
+  byte queueItems;              // Nb of queued telegrams
+  word queueOverflowNb;         // Nb of telegrams lost because the queue was full
+  word busTelegramsNb;          // Nb of telegrams seen on the bus (addressed to us or not, erroneous included)
+  KnxTelegram telegram;         // Telegram being received
+  byte readBytesNb;             // Nb of read bytes during an KNX telegram reception
+  byte expectedTelegramLength;  // Telegram length announced by the routing field
+  boolean telegramCompletelyReceived; // True as soon as the expected nb of bytes has been received
+  unsigned long lastByteTime;   // Reception time (micros) of the last handled byte
 } TpUartRx;
 
 // --- Definitions for the TRANSMISSION  part ----
@@ -151,6 +188,8 @@ typedef struct TpUartTx {
   AckCallbackFctPtr ackFctPtr; // Pointer to callback function for TX ack
   byte nbRemainingBytes;            // Nb of bytes remaining to be transmitted
   byte txByteIndex;                 // Index of the byte to be sent
+  unsigned long startTimeMicros;    // Time (micros) sendTelegram() has been called
+  unsigned long sentTimeMicros;     // Time (micros) the last byte has been handed over to the UART
 } TpUartTx;
 
 
@@ -170,6 +209,13 @@ class KnxTpUart {
     KnxComObject *_comObjectsList;            // Attached list of com objects
     byte _assignedComObjectsNb;               // Nb of assigned com objects
     byte _stateIndication;                    // Value of the last received state indication
+    LockFreeRingBuff<TpUartRxByte, KNX_RX_RING_SIZE> _rxRing; // Received bytes not yet handled by rxTask()
+    boolean _rxIsrMode;                       // True if rxCollect() is called by an ISR/UART callback
+    byte _rxByteBudget;                       // Max. nb of received bytes handled by one rxTask() call
+    boolean _txBurstMode;                     // True if the telegrams are handed over to the UART in one write
+    unsigned long _txHandOverTime;            // Duration (micros) of the last telegram hand over
+    word _txAckTimeout;                       // Time (ms) to wait for the confirm of a sent telegram
+    unsigned long _txConfirmLatency;          // Duration (micros) from hand over to confirm of the last confirmed telegram
 
 
   public:  
@@ -198,18 +244,35 @@ class KnxTpUart {
     // NB : every state indication value change is notified by a "TPUART_EVENT_STATE_INDICATION" event
     byte getStateIndication(void) const;
 
-    // Get the reference to the telegram received by the TPUART
-    // NB : every received telegram content change is notified by a "TPUART_EVENT_RECEIVED_KNX_TELEGRAM" event
+    // Get the nb of received telegrams waiting in the queue
+    // NB : the received telegrams are queued by rxTask(), no event is sent
+    byte getReceivedTelegramsNb(void) const;
+
+    // Get the reference to the oldest received telegram in the queue
+    // NB : only valid if getReceivedTelegramsNb() is not 0
     KnxTelegram& getReceivedTelegram(void);
 
-    // Get the index of the com object targeted by the last received telegram
-    //byte GetTargetedComObjectIndex(void) const;
+    // Get the com objects targeted by the oldest received telegram in the queue
     AddressedComObjects getAddressedComObjects(void) const;
 
+    // Remove the oldest received telegram from the queue
+    void releaseReceivedTelegram(void);
+
+    // Get the nb of received telegrams lost because the queue was full
+    word getRxQueueOverflowNb(void) const;
+
+    // Get the nb of telegrams seen on the bus (wraps around), to observe the bus traffic
+    word getBusTelegramsNb(void) const;
+
     // returns true if there is an activity ongoing (RX/TX) on the TPUART
     // false when there's no activity or when the tpuart is not initialized
     boolean isActive(void) const;
 
+    // Get the time (us) until rxTask()/txTask() need to run: 0 if there is work to do now (received bytes
+    // to handle, reception to poll, telegram to hand over), the time to the EOP or ACK timeout otherwise,
+    // KNX_TPUART_NO_DEADLINE if only new UART activity needs them
+    unsigned long getTaskDelay(void);
+
   // Functions NOT INLINED
     // Reset the Arduino UART port and the TPUART device
     // Return KNX_TPUART_ERROR in case of TPUART reset failure
@@ -232,14 +295,48 @@ class KnxTpUart {
     // NB : the source address is forced to TPUART physical address value
     byte sendTelegram(KnxTelegram& sentTelegram);
 
+    // Collect all bytes available at the UART into the RX ring, each one stamped with its reception time (micros)
+    // Either called by rxTask() itself (default), or - in RX ISR mode - by a timer ISR or UART receive callback.
+    // There must be exactly one caller (single producer).
+    // Returns the nb of collected bytes
+    byte rxCollect(void);
+
+    // Select who calls rxCollect(): true = an ISR/UART callback provided by the application, false = rxTask()
+    // return KNX_TPUART_ERROR_NOT_INIT_STATE (254) if the TPUART is neither in Reset nor in Init state
+    // The function must be called prior to Init() execution, preferably prior to Reset() execution
+    byte setRxIsrMode(boolean isrMode);
+
+    // Set the max. nb of received bytes handled by one rxTask() call (min. 1, default KNX_RX_BYTE_BUDGET)
+    // 1 handles one byte per call, bigger values drain all the available bytes up to the budget
+    void setRxByteBudget(byte budget);
+
     // Reception task
     // This function shall be called periodically in order to allow a correct reception of the KNX bus data
+    // All the available bytes (up to the RX byte budget) are handled in one call.
     // Assuming the TPUART speed is configured to 19200 baud, a character (8 data + 1 start + 1 parity + 1 stop)
     // is transmitted in 0,58ms.
-    // In order not to miss any End Of Packets (i.e. a gap from 2 to 2,5ms), the function shall be called at a max period of 0,5ms.
-    // Typical calling period is 400 usec.
+    // End Of Packets (i.e. a gap from 2 to 2,5ms) are detected with the reception time of each byte.
+    // In RX ISR mode the calling period is therefore not critical for EOP detection, else the function
+    // shall be called at a max period of 0,5ms. Typical calling period is 400 usec.
     void rxTask(void);
 
+    // Select how a telegram is handed over to the TPUART
+    // false (default): one control field/data byte pair per txTask() call
+    // true: the whole telegram in one write, as far as the UART TX buffer (availableForWrite()) can take it.
+    //       For transceivers buffering a complete frame (TP-UART2, NCN5120, ...)
+    // In both modes, nothing is written while the ACK of a telegram being received is pending
+    void setTxBurstMode(boolean burstMode);
+
+    // Get the duration (micros) from sendTelegram() until the last byte of the telegram has been handed over to the UART
+    unsigned long getTxHandOverTime(void) const;
+
+    // Set the time (ms) to wait for the confirm (ACK/NACK) of a sent telegram before NO_ANSWER_TIMEOUT is notified
+    // Default KNX_TX_ACK_TIMEOUT
+    void setAckTimeout(word timeoutMillis);
+
+    // Get the duration (micros) from the hand over of the last confirmed telegram until its confirm (ACK or NACK)
+    unsigned long getTxConfirmLatency(void) const;
+
     // Transmission task
     // This function shall be called periodically in order to allow a correct transmission of the KNX bus data
     // Assuming the TP-Uart speed is configured to 19200 baud, a character (8 data + 1 start + 1 parity + 1 stop)
@@ -258,12 +355,24 @@ class KnxTpUart {
   private:
 
     AddressedComObjects _addressedComObjects;
+    byte _progComObjIndex;                    // Index of the programming com object, target of the prog GA
 
   // Private NOT INLINED functions 
     // Check if the target address points to an assigned com object (i.e. the target address equals a com object address)
-    // if yes, then update index parameter with the index (in the list) of the targeted com object and return true
+    // if yes, then update _addressedComObjects with the indexes of the targeted com objects and return true
     // else return false
+    // Constant time (see KnxAddressIndex), as it runs between routing field reception and the ACK decision
     boolean isAddressAssigned(word addr);
+
+    // Check if the telegram reception is completed (End Of Packet) at the given time, and handle the telegram if so
+    void rxCheckEop(unsigned long nowTime);
+
+    // Burst mode: hand over as much of the telegram being sent as the UART TX buffer can take
+    void txBurst(void);
+
+    // Run the RX state machine with one received byte
+    // Returns false if the byte was a TPUART reset indication (the RX part has been reset then)
+    boolean rxHandleByte(const TpUartRxByte& rxByte);
 };
 
 
@@ -285,14 +394,45 @@ inline byte KnxTpUart::setAckCallback(AckCallbackFctPtr ackFctPtr)
   return KNX_TPUART_OK;
 }
 
+inline byte KnxTpUart::setRxIsrMode(boolean isrMode)
+{
+  if ((_rx.state!=RX_RESET) && (_rx.state!=RX_INIT)) return KNX_TPUART_ERROR_NOT_INIT_STATE;
+  _rxIsrMode = isrMode;
+  return KNX_TPUART_OK;
+}
+
+inline void KnxTpUart::setRxByteBudget(byte budget)
+{ _rxByteBudget = budget ? budget : 1; }
+
+inline void KnxTpUart::setTxBurstMode(boolean burstMode) { _txBurstMode = burstMode; }
+
+inline unsigned long KnxTpUart::getTxHandOverTime(void) const { return _txHandOverTime; }
+
+inline void KnxTpUart::setAckTimeout(word timeoutMillis) { _txAckTimeout = timeoutMillis; }
+
+inline unsigned long KnxTpUart::getTxConfirmLatency(void) const { return _txConfirmLatency; }
+
 inline byte KnxTpUart::getStateIndication(void) const { return _stateIndication; }
 
+inline byte KnxTpUart::getReceivedTelegramsNb(void) const { return _rx.queueItems; }
+
 inline KnxTelegram& KnxTpUart::getReceivedTelegram(void)
-{ return _rx.receivedTelegram; }
+{ return _rx.queue[_rx.queueHead].telegram; }
 
 
 inline AddressedComObjects KnxTpUart::getAddressedComObjects(void) const
-{ return _addressedComObjects; }
+{ return _rx.queue[_rx.queueHead].addressedComObjects; }
+
+inline void KnxTpUart::releaseReceivedTelegram(void)
+{
+  if (!_rx.queueItems) return;
+  _rx.queueHead = (_rx.queueHead + 1) % KNX_RX_TELEGRAM_QUEUE_SIZE;
+  _rx.queueItems--;
+}
+
+inline word KnxTpUart::getRxQueueOverflowNb(void) const { return _rx.queueOverflowNb; }
+
+inline word KnxTpUart::getBusTelegramsNb(void) const { return _rx.busTelegramsNb; }
 
 
 inline boolean KnxTpUart::isActive(void) const
@@ -73,6 +73,7 @@ KonnektingDevice &Konnekting = KonnektingDevice::Konnekting;  // maybe this line
 AssociationTable KonnektingDevice::_associationTable;
 AddressTable KonnektingDevice::_addressTable;
 byte KonnektingDevice::_assocMaxTableEntries = 0;
+KnxAddressIndex KonnektingDevice::_addressIndex;
 // ---------------
 
 /**************************************************************************/
@@ -172,6 +173,10 @@ void KonnektingDevice::internalInit(HardwareSerial &serial, word manufacturerID,
     _deviceFlags = memoryRead(EEPROM_DEVICE_FLAGS);
     DEBUG_PRINTLN(F("_deviceFlags: (bin)" BYTETOBINARYPATTERN), BYTETOBINARY(_deviceFlags));
 
+    // the KNX device must not run while the tables and the GA index are (re)built:
+    // the received telegrams still queued point into the index
+    Knx.end();
+
     if (!isFactorySetting()) {
         DEBUG_PRINTLN(F("->MEMORY"));
         /*
@@ -276,6 +281,17 @@ void KonnektingDevice::internalInit(HardwareSerial &serial, word manufacturerID,
         _assocMaxTableEntries = overallMax;
         DEBUG_PRINTLN(F("Reading association table...*done* _assocMaxTableEntries=%d"), _assocMaxTableEntries);
 
+        /* *************************************
+         * build GA lookup index
+         * *************************************/
+        _addressIndex.build(_addressTable.address, _addressTable.size,
+                            _associationTable.gaId, _associationTable.coId, _associationTable.size);
+        DEBUG_PRINTLN(F("Building GA lookup index...*done*"));
+
+        if (_warmStartOffset >= 0) {
+            restoreWarmStart();
+        }
+
         // params are read either on demand or in setup() and not on init() ...
 
     } else {
@@ -561,6 +577,7 @@ KnxComObject KonnektingDevice::createProgComObject() {
  */
 /**************************************************************************/
 void KonnektingDevice::reboot() {
+    saveWarmStart();
     Knx.end();
 
 #if defined(ESP8266) || defined(ESP32)
@@ -1313,6 +1330,214 @@ int KonnektingDevice::getFreeEepromOffset() {
     return offset;
 }
 
+/**************************************************************************/
+/*!
+ *  @brief  Enables the warm start: the values of the com objects with Init
+ *          attribute are persisted and restored by init(), instead of being
+ *          read from the bus
+ *  @param  offset
+ *          memory index of the snapshot, 0 = getFreeEepromOffset()
+ *  @param  minIntervalMillis
+ *          min. time between two snapshots
+ *  @param  memorySize
+ *          size of the memory, 0 = EEPROM.length()
+ *  @return void
+ */
+/**************************************************************************/
+void KonnektingDevice::enableWarmStart(int offset, unsigned long minIntervalMillis, int memorySize) {
+    _warmStartOffset = offset ? offset : getFreeEepromOffset();
+    _warmStartInterval = minIntervalMillis;
+    _warmStartMemorySize = memorySize;
+}
+
+/**************************************************************************/
+/*!
+ *  @brief  Gets the size of the warm start snapshot:
+ *          magic byte, checksum, then per com object with Init attribute
+ *          a valid flag and the value
+ *  @return size in bytes
+ */
+/**************************************************************************/
+int KonnektingDevice::getWarmStartSize() {
+    int size = 3;
+    for (byte i = 0; i < Knx.getNumberOfComObjects(); i++) {
+        if (Knx.getComObjectIndicator(i) & KNX_COM_OBJ_I_INDICATOR) {
+            byte length = Knx.getComObjectLength(i);
+            size += 1 + (length <= 2 ? 1 : length - 1);
+        }
+    }
+    return size;
+}
+
+static void fletcher16(word &sum1, word &sum2, byte data) {
+    sum1 = (sum1 + data) % 255;
+    sum2 = (sum2 + sum1) % 255;
+}
+
+/**************************************************************************/
+/*!
+ *  @brief  Calculates the checksum of the configuration the com object
+ *          values belong to (com object attributes and lengths, address
+ *          and association tables), so that a snapshot taken with another
+ *          configuration is not restored
+ *  @return Fletcher-16 checksum
+ */
+/**************************************************************************/
+word KonnektingDevice::calcWarmStartChecksum() {
+    word sum1 = 0;
+    word sum2 = 0;
+    fletcher16(sum1, sum2, Knx.getNumberOfComObjects());
+    for (byte i = 0; i < Knx.getNumberOfComObjects(); i++) {
+        fletcher16(sum1, sum2, Knx.getComObjectIndicator(i));
+        fletcher16(sum1, sum2, Knx.getComObjectLength(i));
+    }
+    fletcher16(sum1, sum2, _addressTable.size);
+    for (byte i = 0; i < _addressTable.size; i++) {
+        fletcher16(sum1, sum2, HI__(_addressTable.address[i]));
+        fletcher16(sum1, sum2, __LO(_addressTable.address[i]));
+    }
+    fletcher16(sum1, sum2, _associationTable.size);
+    for (byte i = 0; i < _associationTable.size; i++) {
+        fletcher16(sum1, sum2, _associationTable.gaId[i]);
+        fletcher16(sum1, sum2, _associationTable.coId[i]);
+    }
+    return (sum2 << 8) | sum1;
+}
+
+/**************************************************************************/
+/*!
+ *  @brief  Checks that the warm start snapshot lies between the KONNEKTING
+ *          area and the end of the memory
+ *  @return true if it does
+ */
+/**************************************************************************/
+bool KonnektingDevice::isWarmStartInBounds() {
+    int memorySize = _warmStartMemorySize;
+#ifndef ARDUINO_ARCH_SAMD
+    if (!memorySize && (*_eepromReadFunc == NULL)) memorySize = EEPROM.length();
+#endif
+    if (!memorySize) {
+        DEBUG_PRINTLN(F("Warm start: memory size unknown, see enableWarmStart()"));
+        return false;
+    }
+    if ((_warmStartOffset < getFreeEepromOffset()) || (_warmStartOffset + getWarmStartSize() > memorySize)) {
+        DEBUG_PRINTLN(F("Warm start: snapshot 0x%04x..0x%04x out of memory bounds"),
+                      _warmStartOffset, _warmStartOffset + getWarmStartSize() - 1);
+        return false;
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+ *  @brief  Restores the com object values of the warm start snapshot,
+ *          if it belongs to the current configuration
+ *          The warm start is disabled if the snapshot is out of memory bounds
+ *  @return void
+ */
+/**************************************************************************/
+void KonnektingDevice::restoreWarmStart() {
+    if (!isWarmStartInBounds()) {
+        _warmStartOffset = -1;
+        return;
+    }
+    int index = _warmStartOffset;
+    _warmStartChecksum = calcWarmStartChecksum();
+    _warmStartReady = true;
+    _lastWarmStartMillis = millis();
+    _warmStartUpdateNb = Knx.getValueUpdateNb();
+    if ((memoryRead(index) != KONNEKTING_WARMSTART_MAGIC) ||
+        (memoryRead(index + 1) != HI__(_warmStartChecksum)) ||
+        (memoryRead(index + 2) != __LO(_warmStartChecksum))) {
+        DEBUG_PRINTLN(F("No warm start snapshot for this configuration"));
+        return;
+    }
+    index += 3;
+
+    byte value[14];
+    byte restored = 0;
+    for (byte i = 0; i < Knx.getNumberOfComObjects(); i++) {
+        if (!(Knx.getComObjectIndicator(i) & KNX_COM_OBJ_I_INDICATOR)) continue;
+        byte length = Knx.getComObjectLength(i);
+        byte size = (length <= 2 ? 1 : length - 1);
+        bool valid = (memoryRead(index++) == 0x01);
+        for (byte b = 0; b < size; b++) {
+            value[b] = memoryRead(index++);
+        }
+        if (valid && (Knx.restoreComObjectValue(i, value) == KNX_DEVICE_OK)) {
+            restored++;
+        }
+    }
+    DEBUG_PRINTLN(F("Warm start: %d com objects restored"), restored);
+}
+
+/**************************************************************************/
+/*!
+ *  @brief  Writes a snapshot byte, if it differs from the stored one
+ *  @return true if the byte has been written
+ */
+/**************************************************************************/
+bool KonnektingDevice::warmStartWrite(int index, byte data) {
+    if (memoryRead(index) == data) return false;
+    memoryWrite(index, data);
+    return true;
+}
+
+/**************************************************************************/
+/*!
+ *  @brief  Writes the warm start snapshot
+ *          Only the bytes which have changed are written (memory wear),
+ *          the memory is committed only if a byte has been written
+ *  @return void
+ */
+/**************************************************************************/
+void KonnektingDevice::saveWarmStart() {
+    if ((_warmStartOffset < 0) || !_initialized || isFactorySetting()) return;
+    if (!_warmStartReady) return;  // not checked by init() (factory setting then)
+    _lastWarmStartMillis = millis();
+    _warmStartUpdateNb = Knx.getValueUpdateNb();  // taken first, updates during the scan are in the next snapshot
+
+    bool rebootRequired = _rebootRequired;  // the snapshot is not a configuration change
+    bool changed = false;
+    int index = _warmStartOffset;
+    changed |= warmStartWrite(index++, KONNEKTING_WARMSTART_MAGIC);
+    changed |= warmStartWrite(index++, HI__(_warmStartChecksum));
+    changed |= warmStartWrite(index++, __LO(_warmStartChecksum));
+
+    byte value[14];
+    for (byte i = 0; i < Knx.getNumberOfComObjects(); i++) {
+        if (!(Knx.getComObjectIndicator(i) & KNX_COM_OBJ_I_INDICATOR)) continue;
+        byte length = Knx.getComObjectLength(i);
+        byte size = (length <= 2 ? 1 : length - 1);
+        bool valid;
+        Knx.readComObjectState(i, value, valid);  // consistent with the KNX task updating it
+        changed |= warmStartWrite(index++, valid ? 0x01 : 0x00);
+        for (byte b = 0; b < size; b++) {
+            changed |= warmStartWrite(index++, valid ? value[b] : 0xFF);
+        }
+    }
+    if (changed) {
+        DEBUG_PRINTLN(F("Warm start snapshot written"));
+        memoryCommit();
+    }
+    _rebootRequired = rebootRequired;
+}
+
+/**************************************************************************/
+/*!
+ *  @brief  Writes the warm start snapshot once the min. interval has elapsed,
+ *          if a com object value has been updated since the last one
+ *          Called by KnxDevice::task()
+ *  @return void
+ */
+/**************************************************************************/
+void KonnektingDevice::warmStartTask() {
+    if (_warmStartOffset < 0) return;
+    if (Knx.getValueUpdateNb() == _warmStartUpdateNb) return;  // nothing to scan
+    if ((millis() - _lastWarmStartMillis) < _warmStartInterval) return;
+    saveWarmStart();
+}
+
 /**************************************************************************/
 /*!
  *  @brief  Sets the function to call when doing 'read' on memory.
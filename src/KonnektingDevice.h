@@ -32,6 +32,7 @@
 #include <Arduino.h>
 
 #include "DebugUtil.h"
+#include "KnxAddressIndex.h"
 #include "KnxDevice.h"
 #include "KnxDptConstants.h"
 
@@ -47,6 +48,10 @@
 #define EEPROM_INDIVIDUALADDRESS_HI 16  ///< EEPROM index for IA, high byte
 #define EEPROM_INDIVIDUALADDRESS_LO 17  ///< EEPROM index for IA, low byte
 
+// Min. time (ms) between two warm start snapshots, see enableWarmStart()
+#define KONNEKTING_WARMSTART_INTERVAL 600000UL
+#define KONNEKTING_WARMSTART_MAGIC 0xA5
+
 #define KONNEKTING_VERSION 0x0000
 #define PROTOCOLVERSION 1
 
@@ -175,6 +180,10 @@ class KonnektingDevice {
      * maximum number of associations of single group address, depends on the programming via suite and the assiciations a usedr set up
     */
     static byte _assocMaxTableEntries;
+    /**
+     * GA -> com objects lookup index, built from address and association table
+     */
+    static KnxAddressIndex _addressIndex;
 
     byte (*_eepromReadFunc)(int);
     void (*_eepromWriteFunc)(int, byte);
@@ -252,6 +261,39 @@ class KonnektingDevice {
 
     int getFreeEepromOffset();
 
+    /**
+     * Persist the values of the com objects with Init attribute, so that init() restores them after a reboot
+     * instead of reading them from the bus (no read storm when a whole line reboots)
+     * A snapshot is written by Knx.task() at most every minIntervalMillis and only if a com object value
+     * has been updated since the last one, only the changed bytes are written. With the budgeted
+     * Knx.task(budgetMicros), the application calls warmStartTask() itself. A snapshot is also written
+     * before a reboot (f.i. after programming).
+     * The snapshot is dropped if the com object configuration, address or association table has changed.
+     * init() disables the warm start if the snapshot does not fit between getFreeEepromOffset() and memorySize.
+     * NB : has to be called prior to init()
+     * @param offset memory index of the snapshot (getWarmStartSize() bytes), 0 = getFreeEepromOffset()
+     * @param minIntervalMillis min. time between two snapshots
+     * @param memorySize size of the memory (bytes), 0 = EEPROM.length() (required with setMemoryReadFunc())
+     */
+    void enableWarmStart(int offset = 0, unsigned long minIntervalMillis = KONNEKTING_WARMSTART_INTERVAL,
+                         int memorySize = 0);
+
+    /**
+     * Get the size (bytes) of the warm start snapshot, known after init()
+     */
+    int getWarmStartSize();
+
+    /**
+     * Write the warm start snapshot now (f.i. on power failure detection), if a value has changed
+     */
+    void saveWarmStart();
+
+    /**
+     * Write the warm start snapshot if due, called by Knx.task()
+     * To be called by the application if it uses Knx.task(budgetMicros)
+     */
+    void warmStartTask();
+
    private:
     bool _rebootRequired = false;
     bool _initialized = false;
@@ -272,6 +314,18 @@ class KonnektingDevice {
 
     bool _progState;
 
+    int _warmStartOffset = -1;          // memory index of the warm start snapshot, -1 = disabled
+    unsigned long _warmStartInterval = KONNEKTING_WARMSTART_INTERVAL;
+    unsigned long _lastWarmStartMillis = 0;
+    int _warmStartMemorySize = 0;       // 0 = EEPROM.length()
+    word _warmStartUpdateNb = 0;        // Knx.getValueUpdateNb() when the last snapshot was taken
+    word _warmStartChecksum = 0;        // checksum of the configuration the com object values belong to
+    bool _warmStartReady = false;       // bounds checked and checksum calculated by init()
+    word calcWarmStartChecksum();
+    bool isWarmStartInBounds();
+    void restoreWarmStart();
+    bool warmStartWrite(int index, byte data);
+
     KnxComObject createProgComObject();
 
     void internalInit(HardwareSerial &serial, word manufacturerID, byte deviceID, byte revisionID);
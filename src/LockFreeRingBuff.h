@@ -0,0 +1,112 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCKFREERINGBUFF_H
+#define LOCKFREERINGBUFF_H
+
+#include "Arduino.h"
+
+/**
+ * Single-producer / single-consumer ring buffer without locks.
+ *
+ * One side (f.i. an ISR or a UART receive callback) calls push(), the other
+ * side (f.i. the main loop) calls pop(). No other synchronisation is needed
+ * as long as there is exactly one producer and one consumer.
+ *
+ * size must be a power of two and not bigger than 128.
+ */
+template<typename T, byte size>
+class LockFreeRingBuff {
+    T _buffer[size];     // item buffer
+    byte _head;          // next index to write, only modified by the producer
+    byte _tail;          // next index to read, only modified by the consumer
+
+public:
+
+    /**
+     * Constructor
+     */
+    LockFreeRingBuff() {
+        _head = 0;
+        _tail = 0;
+    };
+
+    /**
+     * Append data (producer side)
+     * @param data
+     * @return false if the buffer is full, the data is not stored then
+     */
+    boolean push(const T& data) {
+        byte head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+        byte tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        if ((byte)(head - tail) == size) return false;
+        _buffer[head & (size - 1)] = data;
+        __atomic_store_n(&_head, (byte)(head + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     * Pop oldest data (consumer side)
+     * @param data the popped data
+     * @return false, if no items available
+     */
+    boolean pop(T& data) {
+        byte tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        byte head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        if (head == tail) return false;
+        data = _buffer[tail & (size - 1)];
+        __atomic_store_n(&_tail, (byte)(tail + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     * Get oldest data without removing it (consumer side)
+     * @param data the oldest data
+     * @return false, if no items available
+     */
+    boolean peek(T& data) const {
+        byte tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        byte head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        if (head == tail) return false;
+        data = _buffer[tail & (size - 1)];
+        return true;
+    }
+
+    /**
+     * Drop all available items (consumer side)
+     */
+    void clear(void) {
+        __atomic_store_n(&_tail, __atomic_load_n(&_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Returns true if there's no space left for another item (producer side)
+     */
+    boolean isFull(void) const {
+        return (byte)(__atomic_load_n(&_head, __ATOMIC_RELAXED) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE)) == size;
+    }
+
+    /**
+     * Returns number of items in buffer
+     * @return item count
+     */
+    byte getItemCount(void) const {
+        return (byte)(__atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE));
+    }
+};
+
+#endif // LOCKFREERINGBUFF_H
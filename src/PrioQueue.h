@@ -0,0 +1,181 @@
+/*
+ *    This file is part of KONNEKTING Device Library.
+ *
+ *    The KONNEKTING Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIOQUEUE_H
+#define PRIOQUEUE_H
+
+#include "Arduino.h"
+
+#define PRIOQUEUE_NONE 0xFF
+
+/**
+ * Queue with several priority levels sharing one item pool.
+ *
+ * Level 0 is the most urgent one. pop() returns the oldest item of the most
+ * urgent non-empty level. To avoid starvation, a waiting level which has been
+ * passed over agingLimit times is served next, whatever its priority is.
+ *
+ * size must be smaller than 255.
+ */
+template<typename T, byte size, byte levels>
+class PrioQueue {
+    T _buffer[size];          // item pool
+    byte _next[size];         // next item in the same level (or in the free list)
+    byte _head[levels];       // oldest item per level
+    byte _tail[levels];       // newest item per level
+    byte _count[levels];      // nb of items per level
+    byte _skipped[levels];    // nb of times a waiting level has been passed over
+    byte _free;               // first free item
+    byte _itemCount;
+    byte _agingLimit;
+
+public:
+
+    /**
+     * Constructor
+     * @param agingLimit nb of times a waiting level may be passed over by more urgent ones
+     */
+    PrioQueue(byte agingLimit = 8) {
+        _agingLimit = agingLimit;
+        clear();
+    };
+
+    /**
+     * Remove all items
+     */
+    void clear(void) {
+        for (byte i = 0; i < size; i++) _next[i] = i + 1;
+        _next[size - 1] = PRIOQUEUE_NONE;
+        _free = 0;
+        for (byte l = 0; l < levels; l++) {
+            _head[l] = PRIOQUEUE_NONE;
+            _tail[l] = PRIOQUEUE_NONE;
+            _count[l] = 0;
+            _skipped[l] = 0;
+        }
+        _itemCount = 0;
+    }
+
+    /**
+     * Append data to the given level
+     * @param data
+     * @param level priority level, 0 = most urgent
+     * @return false if the queue is full (use evict() to make space)
+     */
+    boolean append(const T& data, byte level) {
+        if (_free == PRIOQUEUE_NONE) return false;
+        if (level >= levels) level = levels - 1;
+        byte item = _free;
+        _free = _next[item];
+        _buffer[item] = data;
+        _next[item] = PRIOQUEUE_NONE;
+        if (_tail[level] == PRIOQUEUE_NONE) _head[level] = item;
+        else _next[_tail[level]] = item;
+        _tail[level] = item;
+        _count[level]++;
+        _itemCount++;
+        return true;
+    }
+
+    /**
+     * Pop the next data to be handled
+     * @param data the popped data
+     * @return false, if no items available
+     */
+    boolean pop(T& data) {
+        byte level = PRIOQUEUE_NONE;
+        for (byte l = 0; l < levels; l++) {
+            if (!_count[l]) continue;
+            if (level == PRIOQUEUE_NONE) level = l;  // most urgent waiting level
+            if (_skipped[l] >= _agingLimit) {        // starving level
+                level = l;
+                break;
+            }
+        }
+        if (level == PRIOQUEUE_NONE) return false;
+
+        for (byte l = 0; l < levels; l++) {
+            if (_count[l] && (l != level)) _skipped[l]++;
+        }
+        _skipped[level] = 0;
+        removeHead(level, data);
+        return true;
+    }
+
+    /**
+     * Find a queued item
+     * @param level level to search in
+     * @param match function returning true for the searched item
+     * @param ctx passed to match
+     * @return the newest matching item (can be modified in place), NULL if not found
+     */
+    T* find(byte level, boolean (*match)(const T&, const void*), const void* ctx) {
+        T* found = NULL;
+        if (level >= levels) level = levels - 1;
+        for (byte item = _head[level]; item != PRIOQUEUE_NONE; item = _next[item]) {
+            if (match(_buffer[item], ctx)) found = &_buffer[item];
+        }
+        return found;
+    }
+
+    /**
+     * Remove the oldest data of the least urgent non-empty level
+     * @param data the removed data
+     * @param minLevel only levels >= minLevel are considered
+     * @return false, if no item found
+     */
+    boolean evict(T& data, byte minLevel = 0) {
+        for (byte l = levels; l-- > minLevel;) {
+            if (_count[l]) {
+                removeHead(l, data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Returns true if there's no space left for another item
+     */
+    boolean isFull(void) const {
+        return _free == PRIOQUEUE_NONE;
+    }
+
+    /**
+     * Returns number of items in buffer
+     * @return item count
+     */
+    byte getItemCount(void) const {
+        return _itemCount;
+    }
+
+private:
+
+    void removeHead(byte level, T& data) {
+        byte item = _head[level];
+        data = _buffer[item];
+        _head[level] = _next[item];
+        if (_head[level] == PRIOQUEUE_NONE) _tail[level] = PRIOQUEUE_NONE;
+        _count[level]--;
+        if (!_count[level]) _skipped[level] = 0;
+        _next[item] = _free;
+        _free = item;
+        _itemCount--;
+    }
+};
+
+#endif // PRIOQUEUE_H